@@ -0,0 +1,139 @@
+// Compares FlatIdMap with std::unordered_map for mapping server entity ids
+// to local entities, as done for every incoming message by the client.
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <argagg/argagg.hpp>
+#include <entt/entity/entity.hpp>
+
+#include "flat_id_map.hpp"
+#include "timer.hpp"
+
+struct Result
+{
+    double Insert{0.0};
+    double Lookup{0.0};
+    std::uint64_t Checksum{0};
+};
+
+template<class InsertFunc, class FindFunc>
+Result run(const std::vector<std::uint32_t>& _Ids, const std::vector<std::uint32_t>& _Lookups,
+           InsertFunc _Insert, FindFunc _Find)
+{
+    Result r;
+    Timer t;
+
+    t.start();
+    for (auto i=0u; i<_Ids.size(); ++i)
+    {
+        _Insert(_Ids[i], entt::entity(i));
+    }
+    t.stop();
+    r.Insert = t.elapsed_ms();
+
+    t.start();
+    for (auto Id : _Lookups)
+    {
+        r.Checksum += entt::to_integral(_Find(Id));
+    }
+    t.stop();
+    r.Lookup = t.elapsed_ms();
+
+    return r;
+}
+
+void report(const std::string& _Name, const Result& _r, std::size_t _n)
+{
+    std::cout << "  " << _Name << ": insert " << _r.Insert << " ms, lookup " << _r.Lookup
+              << " ms (" << _r.Lookup*1.0e6/_n << " ns/lookup), checksum " << _r.Checksum << std::endl;
+}
+
+void benchmark(const std::string& _Title, const std::vector<std::uint32_t>& _Ids,
+               const std::vector<std::uint32_t>& _Lookups, bool _Reserve)
+{
+    std::cout << _Title << (_Reserve ? " (reserved)" : "") << std::endl;
+
+    {
+        std::unordered_map<std::uint32_t, entt::entity> Map;
+        if (_Reserve) Map.reserve(_Ids.size());
+        auto r = run(_Ids, _Lookups,
+                     [&Map](std::uint32_t _Id, entt::entity _e) {Map[_Id] = _e;},
+                     [&Map](std::uint32_t _Id)
+                     {
+                         auto it = Map.find(_Id);
+                         return it != Map.end() ? it->second : entt::entity{entt::null};
+                     });
+        report("std::unordered_map", r, _Lookups.size());
+    }
+    {
+        FlatIdMap Map;
+        if (_Reserve) Map.reserve(_Ids.size());
+        auto r = run(_Ids, _Lookups,
+                     [&Map](std::uint32_t _Id, entt::entity _e) {Map.insert(_Id, _e);},
+                     [&Map](std::uint32_t _Id) {return Map.find(_Id);});
+        report("FlatIdMap         ", r, _Lookups.size());
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    argagg::parser ArgParser
+    {{
+        { "help", {"-h", "--help"},
+          "Shows this help message", 0},
+        { "number", {"-n", "--number"},
+          "Number of entity ids (default: 1000000)", 1},
+    }};
+
+    argagg::parser_results Args;
+    try
+    {
+        Args = ArgParser.parse(argc, argv);
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    if (Args["help"])
+    {
+        std::cerr << ArgParser;
+        return EXIT_SUCCESS;
+    }
+    const std::uint32_t n = Args["number"].as<std::uint32_t>(1000000);
+
+    std::mt19937 Gen(42);
+
+    // Server ids are mostly sequential, but arrive shuffled from batches of
+    // different subscriptions
+    std::vector<std::uint32_t> Sequential(n);
+    std::iota(Sequential.begin(), Sequential.end(), 0u);
+
+    std::vector<std::uint32_t> Random(n);
+    std::uniform_int_distribution<std::uint32_t> Dist;
+    std::generate(Random.begin(), Random.end(), [&]() {return Dist(Gen);});
+
+    auto Lookups = [&Gen](std::vector<std::uint32_t> _Ids)
+    {
+        std::shuffle(_Ids.begin(), _Ids.end(), Gen);
+        return _Ids;
+    };
+
+    const auto SequentialLookups = Lookups(Sequential);
+    const auto RandomLookups = Lookups(Random);
+
+    for (auto Reserve : {false, true})
+    {
+        benchmark("Sequential ids, " + std::to_string(n) + " entries", Sequential, SequentialLookups, Reserve);
+        benchmark("Random ids, " + std::to_string(n) + " entries", Random, RandomLookups, Reserve);
+    }
+
+    return EXIT_SUCCESS;
+}
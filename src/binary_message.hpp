@@ -0,0 +1,139 @@
+#ifndef BINARY_MESSAGE_HPP
+#define BINARY_MESSAGE_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+// Compact binary encoding of high volume notifications, sent as binary
+// websocket frames. Control messages stay JSON-RPC.
+//
+// Layout (host byte order, client and server are expected to be little
+// endian):
+//   Header   : Magic (u32), Version (u16), Type (u16), Count (u32),
+//              Time (f64, since version 2)
+//   Records  : Count times the fixed size record of the given type
+//
+// Time is the server simulation time the message was emitted at, see
+// clock_sync.hpp
+//
+//   DYNAMIC_DATA   : eid (u32), m, r, spx, spy, px, py (f64), name (char[32])
+//   GALAXY_STARS   : eid (u32), sc (i32), m, r, spx, spy, t (f64), name (char[32])
+//   GALAXY_SYSTEMS : eid (u32), name (char[32])
+//   TIRE_DATA      : eid (u32), rim_x, rim_y, rim_r (f64), rubber (f64[64])
+//   DYNAMIC_DELTA  : eid (u32), seq (u32), fields (u8), then only the fields
+//                    given by the mask (see dynamic_update.hpp) in the order
+//                    m, r, spx, spy, px, py (f64), name (char[32])
+
+enum class BinaryMessageE : std::uint16_t
+{
+    DYNAMIC_DATA = 1,
+    GALAXY_STARS = 2,
+    GALAXY_SYSTEMS = 3,
+    TIRE_DATA = 4,
+    DYNAMIC_DELTA = 5
+};
+
+struct BinaryHeader
+{
+    static constexpr std::uint32_t MAGIC = 0x474e5750; // "PWNG"
+    static constexpr std::uint16_t VERSION = 2;
+    // Oldest version still read, without time
+    static constexpr std::uint16_t VERSION_MIN = 1;
+    static constexpr std::size_t SIZE = 20;
+
+    std::uint32_t Magic{MAGIC};
+    std::uint16_t Version{VERSION};
+    BinaryMessageE Type{BinaryMessageE::DYNAMIC_DATA};
+    std::uint32_t Count{0};
+    double Time{0.0};
+
+    bool hasTime() const {return Version >= 2;}
+};
+
+// Names have the same fixed length as NameComponent
+constexpr std::size_t BINARY_NAME_SIZE = 32;
+constexpr int BINARY_TIRE_SEGMENTS = 32;
+
+class BinaryWriter
+{
+
+    public:
+
+        explicit BinaryWriter(std::string& _Buffer) : Buffer_(_Buffer) {}
+
+        void writeHeader(BinaryMessageE _Type, std::uint32_t _Count, double _Time = 0.0)
+        {
+            this->write(BinaryHeader::MAGIC);
+            this->write(BinaryHeader::VERSION);
+            this->write(static_cast<std::uint16_t>(_Type));
+            this->write(_Count);
+            this->write(_Time);
+        }
+
+        template<class T>
+        void write(T _v)
+        {
+            Buffer_.append(reinterpret_cast<const char*>(&_v), sizeof(T));
+        }
+
+        void writeName(const char* _Name)
+        {
+            char Name[BINARY_NAME_SIZE]{};
+            std::strncpy(Name, _Name, BINARY_NAME_SIZE-1);
+            Buffer_.append(Name, BINARY_NAME_SIZE);
+        }
+
+    private:
+
+        std::string& Buffer_;
+};
+
+class BinaryReader
+{
+
+    public:
+
+        BinaryReader(const char* _Data, std::size_t _Size) :
+            Cursor_(_Data), End_(_Data+_Size) {}
+
+        bool readHeader(BinaryHeader& _Header)
+        {
+            std::uint16_t Type{0};
+            if (!(this->read(_Header.Magic) && this->read(_Header.Version) &&
+                  this->read(Type) && this->read(_Header.Count))) return false;
+            _Header.Type = static_cast<BinaryMessageE>(Type);
+            if (_Header.Magic != BinaryHeader::MAGIC ||
+                _Header.Version < BinaryHeader::VERSION_MIN ||
+                _Header.Version > BinaryHeader::VERSION) return false;
+            return !_Header.hasTime() || this->read(_Header.Time);
+        }
+
+        template<class T>
+        bool read(T& _v)
+        {
+            if (End_ - Cursor_ < static_cast<std::ptrdiff_t>(sizeof(T))) return false;
+            std::memcpy(&_v, Cursor_, sizeof(T));
+            Cursor_ += sizeof(T);
+            return true;
+        }
+
+        // Returns name in place, not necessarily null terminated
+        bool readName(const char*& _Name, std::size_t& _Length)
+        {
+            if (End_ - Cursor_ < static_cast<std::ptrdiff_t>(BINARY_NAME_SIZE)) return false;
+            _Name = Cursor_;
+            _Length = strnlen(Cursor_, BINARY_NAME_SIZE);
+            Cursor_ += BINARY_NAME_SIZE;
+            return true;
+        }
+
+        std::size_t remaining() const {return End_ - Cursor_;}
+
+    private:
+
+        const char* Cursor_;
+        const char* End_;
+};
+
+#endif // BINARY_MESSAGE_HPP
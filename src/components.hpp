@@ -29,6 +29,19 @@ struct HookComponent
 // 31 characters and trailing delimiter (\0)
 constexpr std::size_t NAME_SIZE_MAX = 32;
 
+// Last two positions received of a dynamic object and the client time they
+// were emitted at (received at, without clock synchronisation). The
+// rendered position is interpolated in between, see MotionSystem
+struct MotionComponent
+{
+    double t0{0.0};
+    double x0{0.0};
+    double y0{0.0};
+    double t1{0.0};
+    double x1{0.0};
+    double y1{0.0};
+};
+
 struct NameComponent
 {
     // Use fixed length char[] to ensure memory is aligned and not dynamically
@@ -69,6 +82,13 @@ static std::unordered_map<SpectralClassE, std::string> SpectralClassToStringMap{
 {SpectralClassE::O, "O"}
 };
 
+// Last applied update sequence of a dynamic object, see dynamic_update.hpp
+struct SequenceComponent
+{
+    std::uint32_t Seq{0};
+    bool IsKeyframeRequested{false};
+};
+
 struct StarDataComponent
 {
     SpectralClassE SpectralClass{SpectralClassE::M};
@@ -103,6 +123,8 @@ struct ZoomComponent
 
 struct DynamicObjectTag{};
 struct InsideViewportTag{};
+// Last known state of a lost connection, not yet updated after reconnecting
+struct StaleTag{};
 struct StarSystemTag{};
 struct StaticObjectTag{};
 
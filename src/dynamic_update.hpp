@@ -0,0 +1,47 @@
+#ifndef DYNAMIC_UPDATE_HPP
+#define DYNAMIC_UPDATE_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+// Update of a dynamic object, decoded from bc_dynamic_data (JSON or binary).
+//
+// Delta updates only carry the fields that changed. Every update of an
+// object has a sequence number, consecutive for that object. A keyframe
+// carries all fields and resets the sequence. If a delta does not directly
+// follow its predecessor, the base was lost and a keyframe is requested.
+// Updates without sequence number are full updates of older servers.
+struct DynamicUpdate
+{
+    // Field mask, also used as is by the binary DYNAMIC_DELTA record
+    static constexpr std::uint8_t FIELD_NAME = 1 << 0;
+    static constexpr std::uint8_t FIELD_MASS = 1 << 1;
+    static constexpr std::uint8_t FIELD_RADIUS = 1 << 2;
+    static constexpr std::uint8_t FIELD_SYSTEM_POSITION = 1 << 3;
+    static constexpr std::uint8_t FIELD_POSITION = 1 << 4;
+    static constexpr std::uint8_t FIELD_KEYFRAME = 1 << 7;
+    static constexpr std::uint8_t FIELDS_ALL = FIELD_NAME | FIELD_MASS | FIELD_RADIUS |
+                                               FIELD_SYSTEM_POSITION | FIELD_POSITION;
+
+    std::uint32_t Eid{0};
+    std::uint32_t Seq{0};
+    bool HasSeq{false};
+    std::uint8_t Fields{0};
+
+    // Name is not necessarily null terminated
+    const char* Name{nullptr};
+    std::size_t NameLength{0};
+    double m{0.0};
+    double r{0.0};
+    double spx{0.0};
+    double spy{0.0};
+    double px{0.0};
+    double py{0.0};
+    // Server simulation time of emission, if given
+    double t{0.0};
+    bool HasTime{false};
+
+    bool isKeyframe() const {return !HasSeq || (Fields & FIELD_KEYFRAME);}
+};
+
+#endif // DYNAMIC_UPDATE_HPP
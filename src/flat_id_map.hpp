@@ -0,0 +1,135 @@
+#ifndef FLAT_ID_MAP_HPP
+#define FLAT_ID_MAP_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include <entt/entity/entity.hpp>
+
+// Maps server entity ids to local entities. Open addressing with linear
+// probing in a single contiguous array, so a lookup usually touches one
+// cache line and inserting does not allocate unless the table grows.
+// Empty slots are marked by entt::null, hence any 32 bit id is a valid key.
+class FlatIdMap
+{
+
+    public:
+
+        FlatIdMap() {this->rehash(CAPACITY_MIN);}
+
+        // Returns entt::null if id is unknown
+        entt::entity find(const std::uint32_t _Id) const
+        {
+            for (auto i = this->index(_Id);; i = (i+1) & Mask_)
+            {
+                const auto& Slot = Slots_[i];
+                if (Slot.Value == entt::null) return entt::null;
+                if (Slot.Id == _Id) return Slot.Value;
+            }
+        }
+
+        // Inserts or replaces the entity of the given id
+        void insert(const std::uint32_t _Id, const entt::entity _e)
+        {
+            if ((Size_+1)*LOAD_DEN > Slots_.size()*LOAD_NUM) this->rehash(Slots_.size()*2);
+
+            for (auto i = this->index(_Id);; i = (i+1) & Mask_)
+            {
+                auto& Slot = Slots_[i];
+                if (Slot.Value == entt::null)
+                {
+                    Slot = {_Id, _e};
+                    ++Size_;
+                    return;
+                }
+                if (Slot.Id == _Id)
+                {
+                    Slot.Value = _e;
+                    return;
+                }
+            }
+        }
+
+        // Grow once for the given number of ids, e.g. before bulk insertion
+        void reserve(const std::size_t _n)
+        {
+            std::size_t Capacity = Slots_.size();
+            while (_n*LOAD_DEN > Capacity*LOAD_NUM) Capacity *= 2;
+            if (Capacity > Slots_.size()) this->rehash(Capacity);
+        }
+
+        // Keeps the capacity
+        void clear()
+        {
+            for (auto& Slot : Slots_) Slot = {0, entt::null};
+            Size_ = 0;
+        }
+
+        // Removes entries _f(id, entity) returns true for. Rebuilds the
+        // table, thus meant for rare bulk removal
+        template<class Func>
+        void eraseIf(Func _f)
+        {
+            std::vector<SlotType> Old(Slots_.size());
+            Old.swap(Slots_);
+            Size_ = 0;
+            for (const auto& Slot : Old)
+            {
+                if (Slot.Value != entt::null && !_f(Slot.Id, Slot.Value)) this->insert(Slot.Id, Slot.Value);
+            }
+        }
+
+        // Calls _f(id, entity) for all entries
+        template<class Func>
+        void each(Func _f) const
+        {
+            for (const auto& Slot : Slots_)
+            {
+                if (Slot.Value != entt::null) _f(Slot.Id, Slot.Value);
+            }
+        }
+
+        std::size_t size() const {return Size_;}
+        std::size_t capacity() const {return Slots_.size();}
+
+    private:
+
+        static constexpr std::size_t CAPACITY_MIN = 1024;
+
+        // Maximum load factor of 3/4
+        static constexpr std::size_t LOAD_NUM = 3;
+        static constexpr std::size_t LOAD_DEN = 4;
+
+        struct SlotType
+        {
+            std::uint32_t Id{0};
+            entt::entity Value{entt::null};
+        };
+
+        // Fibonacci hashing, server ids are often sequential
+        std::size_t index(const std::uint32_t _Id) const
+        {
+            return static_cast<std::size_t>((_Id * 0x9e3779b97f4a7c15ull) >> Shift_) & Mask_;
+        }
+
+        void rehash(const std::size_t _Capacity)
+        {
+            std::vector<SlotType> Old(_Capacity);
+            Old.swap(Slots_);
+            Mask_ = _Capacity-1;
+            Shift_ = 64;
+            for (auto c = _Capacity; c > 1; c >>= 1) --Shift_;
+            Size_ = 0;
+            for (const auto& Slot : Old)
+            {
+                if (Slot.Value != entt::null) this->insert(Slot.Id, Slot.Value);
+            }
+        }
+
+        std::vector<SlotType> Slots_;
+        std::size_t Mask_{0};
+        unsigned Shift_{64};
+        std::size_t Size_{0};
+};
+
+#endif // FLAT_ID_MAP_HPP
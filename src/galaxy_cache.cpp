@@ -0,0 +1,154 @@
+#include "galaxy_cache.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Columns are mapped as is, components must not hold pointers
+static_assert(std::is_trivially_copyable<SystemPositionComponent>::value, "Component not mappable");
+static_assert(std::is_trivially_copyable<MassComponent>::value, "Component not mappable");
+static_assert(std::is_trivially_copyable<RadiusComponent>::value, "Component not mappable");
+static_assert(std::is_trivially_copyable<StarDataComponent>::value, "Component not mappable");
+static_assert(std::is_trivially_copyable<NameComponent>::value, "Component not mappable");
+
+static std::size_t align8(std::size_t _Offset)
+{
+    return (_Offset + 7) & ~std::size_t(7);
+}
+
+GalaxyCache::Layout::Layout(std::size_t _Stars, std::size_t _Systems, std::size_t _Vertices) :
+    Stars(_Stars), Systems(_Systems), Vertices(_Vertices)
+{
+    StarIds = align8(sizeof(Header));
+    StarPositions = align8(StarIds + Stars * sizeof(std::uint32_t));
+    StarMasses = align8(StarPositions + Stars * sizeof(SystemPositionComponent));
+    StarRadii = align8(StarMasses + Stars * sizeof(MassComponent));
+    StarData = align8(StarRadii + Stars * sizeof(RadiusComponent));
+    StarNames = align8(StarData + Stars * sizeof(StarDataComponent));
+    SystemIds = align8(StarNames + Stars * sizeof(NameComponent));
+    SystemNames = align8(SystemIds + Systems * sizeof(std::uint32_t));
+    VertexData = align8(SystemNames + Systems * sizeof(NameComponent));
+    Size = align8(VertexData + Vertices * sizeof(float));
+}
+
+bool GalaxyCache::load()
+{
+    this->unload();
+
+    int fd = ::open(File_.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat FileStat;
+    if (::fstat(fd, &FileStat) != 0 || std::size_t(FileStat.st_size) < sizeof(Header))
+    {
+        ::close(fd);
+        return false;
+    }
+
+    void* Data = ::mmap(nullptr, FileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (Data == MAP_FAILED) return false;
+
+    Header Head;
+    std::memcpy(&Head, Data, sizeof(Header));
+    Layout Lay(Head.Stars, Head.Systems, Head.Vertices);
+    if (Head.Magic != MAGIC || Head.Version != VERSION ||
+        Lay.Size != std::size_t(FileStat.st_size))
+    {
+        ::munmap(Data, FileStat.st_size);
+        return false;
+    }
+
+    Data_ = Data;
+    Size_ = FileStat.st_size;
+    Layout_ = Lay;
+    Hash_.assign(Head.Hash, strnlen(Head.Hash, HASH_SIZE));
+    return true;
+}
+
+void GalaxyCache::unload()
+{
+    if (Data_ != nullptr) ::munmap(Data_, Size_);
+    Data_ = nullptr;
+    Size_ = 0;
+    Layout_ = Layout();
+    Hash_.clear();
+}
+
+bool GalaxyCache::write(const std::string& _Hash, const entt::registry& _Reg,
+                        const FlatIdMap& _IdMap, const std::vector<float>& _Vertices)
+{
+    if (_Hash.empty() || _Hash.size() >= HASH_SIZE) return false;
+
+    std::vector<std::uint32_t> StarIds;
+    std::vector<entt::entity> Stars;
+    std::vector<std::uint32_t> SystemIds;
+    std::vector<entt::entity> Systems;
+    _IdMap.each([&](std::uint32_t _Id, entt::entity _e)
+    {
+        if (!_Reg.valid(_e)) return;
+        if (_Reg.all_of<SystemPositionComponent, MassComponent, RadiusComponent,
+                        StarDataComponent, NameComponent>(_e))
+        {
+            StarIds.push_back(_Id);
+            Stars.push_back(_e);
+        }
+        else if (_Reg.all_of<StarSystemTag, NameComponent>(_e))
+        {
+            SystemIds.push_back(_Id);
+            Systems.push_back(_e);
+        }
+    });
+
+    Header Head;
+    std::strncpy(Head.Hash, _Hash.c_str(), HASH_SIZE-1);
+    Head.Stars = Stars.size();
+    Head.Systems = Systems.size();
+    Head.Vertices = _Vertices.size();
+    Layout Lay(Head.Stars, Head.Systems, Head.Vertices);
+
+    // Fill image in memory, columns are written at their offsets
+    std::vector<char> Image(Lay.Size, 0);
+    std::memcpy(Image.data(), &Head, sizeof(Header));
+    auto put = [&Image](std::size_t _Offset, std::size_t _i, const auto& _v)
+    {
+        std::memcpy(Image.data() + _Offset + _i*sizeof(_v), &_v, sizeof(_v));
+    };
+    for (auto i=0u; i<Stars.size(); ++i)
+    {
+        const auto e = Stars[i];
+        put(Lay.StarIds, i, StarIds[i]);
+        put(Lay.StarPositions, i, _Reg.get<SystemPositionComponent>(e));
+        put(Lay.StarMasses, i, _Reg.get<MassComponent>(e));
+        put(Lay.StarRadii, i, _Reg.get<RadiusComponent>(e));
+        put(Lay.StarData, i, _Reg.get<StarDataComponent>(e));
+        put(Lay.StarNames, i, _Reg.get<NameComponent>(e));
+    }
+    for (auto i=0u; i<Systems.size(); ++i)
+    {
+        put(Lay.SystemIds, i, SystemIds[i]);
+        put(Lay.SystemNames, i, _Reg.get<NameComponent>(Systems[i]));
+    }
+    if (!_Vertices.empty())
+    {
+        std::memcpy(Image.data() + Lay.VertexData, _Vertices.data(), _Vertices.size()*sizeof(float));
+    }
+
+    // Replace cache atomically, a mapped old cache stays valid until unmapped
+    const std::string TmpFile = File_ + ".tmp";
+    {
+        std::ofstream File(TmpFile, std::ios::binary | std::ios::trunc);
+        File.write(Image.data(), Image.size());
+        if (!File) return false;
+    }
+    this->unload();
+    if (std::rename(TmpFile.c_str(), File_.c_str()) != 0) return false;
+
+    return this->load();
+}
@@ -0,0 +1,118 @@
+#ifndef GALAXY_CACHE_HPP
+#define GALAXY_CACHE_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <entt/entity/registry.hpp>
+
+#include "components.hpp"
+#include "flat_id_map.hpp"
+
+// On-disk cache of the static galaxy (stars and star systems), so that a
+// reconnect doesn't need to stream it again. The file is memory mapped and
+// its columns have the binary layout of the components, hence they are
+// inserted into the registry and the galaxy vertex buffer as is. A cache
+// is only valid for the same client build (see VERSION) and the same
+// server galaxy, identified by the hash the server announces.
+//
+// Layout (host byte order, each column aligned to 8 bytes):
+//   Header  : Magic (u32), Version (u32), Hash (char[64]),
+//             Stars (u64), Systems (u64), Vertices (u64)
+//   Stars   : eid (u32[Stars]), SystemPositionComponent[Stars],
+//             MassComponent[Stars], RadiusComponent[Stars],
+//             StarDataComponent[Stars], NameComponent[Stars]
+//   Systems : eid (u32[Systems]), NameComponent[Systems]
+//   Vertices: float[Vertices], as used by RenderSystem::buildGalaxyMesh
+class GalaxyCache
+{
+
+    public:
+
+        static constexpr std::uint32_t MAGIC = 0x43474750; // "PGGC"
+        static constexpr std::uint32_t VERSION = 1;
+        static constexpr std::size_t HASH_SIZE = 64;
+
+        GalaxyCache() = default;
+        GalaxyCache(const GalaxyCache&) = delete;
+        GalaxyCache& operator=(const GalaxyCache&) = delete;
+        ~GalaxyCache() {this->unload();}
+
+        void setFile(const std::string& _File) {File_ = _File;}
+
+        // Maps the cache file, returns false if missing or invalid
+        bool load();
+        void unload();
+
+        // Writes galaxy of the given registry and reloads the cache
+        bool write(const std::string& _Hash, const entt::registry& _Reg,
+                   const FlatIdMap& _IdMap, const std::vector<float>& _Vertices);
+
+        // Hash of the server galaxy, empty if no cache is loaded
+        const std::string& getHash() const {return Hash_;}
+        bool isLoaded() const {return Data_ != nullptr;}
+
+        std::size_t getStarCount() const {return Layout_.Stars;}
+        std::size_t getSystemCount() const {return Layout_.Systems;}
+        std::size_t getVertexCount() const {return Layout_.Vertices;}
+
+        const std::uint32_t* getStarIds() const {return this->column<std::uint32_t>(Layout_.StarIds);}
+        const SystemPositionComponent* getStarPositions() const {return this->column<SystemPositionComponent>(Layout_.StarPositions);}
+        const MassComponent* getStarMasses() const {return this->column<MassComponent>(Layout_.StarMasses);}
+        const RadiusComponent* getStarRadii() const {return this->column<RadiusComponent>(Layout_.StarRadii);}
+        const StarDataComponent* getStarData() const {return this->column<StarDataComponent>(Layout_.StarData);}
+        const NameComponent* getStarNames() const {return this->column<NameComponent>(Layout_.StarNames);}
+        const std::uint32_t* getSystemIds() const {return this->column<std::uint32_t>(Layout_.SystemIds);}
+        const NameComponent* getSystemNames() const {return this->column<NameComponent>(Layout_.SystemNames);}
+        const float* getVertices() const {return this->column<float>(Layout_.VertexData);}
+
+    private:
+
+        struct Header
+        {
+            std::uint32_t Magic{MAGIC};
+            std::uint32_t Version{VERSION};
+            char Hash[HASH_SIZE]{};
+            std::uint64_t Stars{0};
+            std::uint64_t Systems{0};
+            std::uint64_t Vertices{0};
+        };
+
+        // Byte offsets of columns for the given counts
+        struct Layout
+        {
+            Layout() = default;
+            Layout(std::size_t _Stars, std::size_t _Systems, std::size_t _Vertices);
+
+            std::size_t Stars{0};
+            std::size_t Systems{0};
+            std::size_t Vertices{0};
+
+            std::size_t StarIds{0};
+            std::size_t StarPositions{0};
+            std::size_t StarMasses{0};
+            std::size_t StarRadii{0};
+            std::size_t StarData{0};
+            std::size_t StarNames{0};
+            std::size_t SystemIds{0};
+            std::size_t SystemNames{0};
+            std::size_t VertexData{0};
+            std::size_t Size{0};
+        };
+
+        template<class T>
+        const T* column(std::size_t _Offset) const
+        {
+            return reinterpret_cast<const T*>(static_cast<const char*>(Data_) + _Offset);
+        }
+
+        std::string File_{"galaxy.cache"};
+        std::string Hash_;
+
+        void* Data_{nullptr};
+        std::size_t Size_{0};
+        Layout Layout_;
+};
+
+#endif // GALAXY_CACHE_HPP
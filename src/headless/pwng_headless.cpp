@@ -0,0 +1,446 @@
+// Headless client. Runs networking, the ingest path, camera logic and
+// viewport culling of the desktop client without window or GL context,
+// e.g. on CI or profiling hosts without display. Per-stage timings are
+// printed at exit.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include <argagg/argagg.hpp>
+#include <concurrentqueue/concurrentqueue.h>
+#include <entt/entity/registry.hpp>
+
+#include "clock_sync.hpp"
+#include "components.hpp"
+#include "galaxy_cache.hpp"
+#include "ingest_manager.hpp"
+#include "interest_system.hpp"
+#include "json_manager.hpp"
+#include "message_handler.hpp"
+#include "method_dispatcher.hpp"
+#include "motion_system.hpp"
+#include "name_system.hpp"
+#include "network_manager.hpp"
+#include "parser_manager.hpp"
+#include "performance_timers.hpp"
+#include "render_system.hpp"
+#include "request_tracker.hpp"
+#include "sim_timer.hpp"
+#include "snapshot_system.hpp"
+#include "subscription_manager.hpp"
+#include "timer.hpp"
+
+static std::atomic<bool> IsInterrupted{false};
+
+class HeadlessClient
+{
+
+    public:
+
+        struct Config
+        {
+            std::string CacheFile{"galaxy.cache"};
+            std::string Server{"ws://localhost:9002/?id=1"};
+            std::string Replay;
+            std::string Record;
+            double ReplaySpeed{1.0};
+            double SnapshotMemory{SnapshotSystem::MEMORY_DEFAULT};
+            double SnapshotSeconds{SnapshotSystem::DURATION_DEFAULT};
+            double Duration{10.0};
+            double Rate{60.0};
+            double Zoom{1.0e-16};
+            bool IsBinary{false};
+            bool IsBatching{false};
+            bool IsInterest{true};
+            bool IsInterpolation{true};
+            bool IsZoomSweep{false};
+            int Width{1024};
+            int Height{768};
+        };
+
+        HeadlessClient();
+
+        bool init(const Config& _Config);
+        void run();
+        void printStats() const;
+
+    private:
+
+        // Accumulated timing of one stage over all frames
+        struct Stage
+        {
+            void add(double _t) {Sum += _t; Max = std::max(Max, _t); ++n;}
+            double avg() const {return n > 0 ? Sum / n : 0.0;}
+
+            double Sum{0.0};
+            double Max{0.0};
+            std::uint64_t n{0};
+        };
+
+        void updateCamera(double _t);
+
+        entt::registry Reg_;
+        moodycamel::BlockingConcurrentQueue<NetworkMessage> InputQueue_;
+        OutgoingQueue OutputQueue_;
+
+        PerformanceTimers Timers_;
+        SimTimer SimTime_;
+
+        Config Config_;
+
+        std::atomic<bool> IsConnectionLostEventTriggered_{false};
+        std::atomic<bool> IsDisconnectEventTriggered_{false};
+        std::atomic<bool> IsReconnectEventTriggered_{false};
+
+        Stage StageFrame_;
+        Stage StageMotion_;
+        Stage StageQueue_;
+        Stage StageSnapshot_;
+        Stage StageViewport_;
+        std::size_t ObjectsInsideViewport_{0};
+};
+
+HeadlessClient::HeadlessClient()
+{
+    Reg_.set<ClockSync>(Reg_);
+    Reg_.set<GalaxyCache>();
+    Reg_.set<IngestManager>(Reg_, Timers_, SimTime_);
+    Reg_.set<InterestSystem>(Reg_);
+    Reg_.set<JsonManager>(Reg_);
+    Reg_.set<MessageHandler>();
+    Reg_.set<MethodDispatcher>();
+    Reg_.set<MotionSystem>(Reg_, Timers_);
+    Reg_.set<NameSystem>(Reg_);
+    Reg_.set<NetworkManager>(Reg_);
+    Reg_.set<ParserManager>(Reg_, Timers_);
+    // Only camera and viewport culling are used, hence no GL context needed
+    Reg_.set<RenderSystem>(Reg_, Timers_);
+    Reg_.set<RequestTracker>(Reg_);
+    Reg_.set<SnapshotSystem>(Reg_, Timers_, SimTime_);
+    Reg_.set<SubscriptionManager>(Reg_);
+
+    auto& Messages = Reg_.ctx<MessageHandler>();
+    Messages.setLevel(MessageHandler::INFO);
+    Messages.registerSource("jsn", "jsn");
+    Messages.registerSource("net", "net");
+    Messages.registerSource("prg", "prg");
+    Messages.registerSource("gfx", "gfx");
+}
+
+bool HeadlessClient::init(const Config& _Config)
+{
+    auto& Cache = Reg_.ctx<GalaxyCache>();
+    auto& Ingest = Reg_.ctx<IngestManager>();
+    auto& Messages = Reg_.ctx<MessageHandler>();
+    auto& Network = Reg_.ctx<NetworkManager>();
+    auto& Renderer = Reg_.ctx<RenderSystem>();
+
+    Config_ = _Config;
+
+    Cache.setFile(Config_.CacheFile);
+    if (Cache.load())
+    {
+        Messages.report("prg", "Galaxy cache loaded (" + std::to_string(Cache.getStarCount()) + " stars)",
+                        MessageHandler::INFO);
+    }
+
+    // There is no UI for camera hooks and no mesh to build, the galaxy is
+    // still written to the cache
+    Ingest.init(&OutputQueue_);
+    Ingest.addListenerCleanup([&Renderer](){Renderer.resetCamera();});
+    Ingest.addListenerRemovedObject([&Renderer](entt::entity _e){Renderer.releaseHook(_e);});
+    Ingest.addListenerGalaxyReceived([&Ingest, &Renderer]()
+    {
+        std::vector<float> Vertices;
+        Renderer.getGalaxyVertices(Vertices);
+        Ingest.writeGalaxyCache(Vertices);
+    });
+
+    if (!Network.init(&InputQueue_, &OutputQueue_)) return false;
+    Network.setBatching(Config_.IsBatching);
+    Reg_.ctx<ParserManager>().init(&InputQueue_);
+    Reg_.ctx<SubscriptionManager>().init(&OutputQueue_);
+    Reg_.ctx<InterestSystem>().init(&OutputQueue_);
+    Reg_.ctx<ClockSync>().init(&OutputQueue_);
+    Reg_.ctx<InterestSystem>().setEnabled(Config_.IsInterest);
+    Reg_.ctx<MotionSystem>().setEnabled(Config_.IsInterpolation);
+    Reg_.ctx<SnapshotSystem>().configure(Config_.SnapshotSeconds,
+                                         static_cast<std::size_t>(Config_.SnapshotMemory * 1024.0 * 1024.0));
+    Network.addListenerConnectionLost([this](){IsConnectionLostEventTriggered_.store(true);});
+    Network.addListenerDisconnect([this](){IsDisconnectEventTriggered_.store(true);});
+    Network.addListenerReconnect([this](){IsReconnectEventTriggered_.store(true);});
+
+    Renderer.setupCamera();
+    Renderer.setWindowSize(Config_.Width, Config_.Height);
+    Reg_.get<ZoomComponent>(Renderer.getCamera()) = {Config_.Zoom, Config_.Zoom};
+
+    if (!Config_.Record.empty()) Network.startRecording(Config_.Record);
+    const bool IsStarted = Config_.Replay.empty() ? Network.connect(Config_.Server) :
+                                                    Network.startReplay(Config_.Replay, Config_.ReplaySpeed);
+    if (!IsStarted)
+    {
+        Network.quit();
+        return false;
+    }
+    if (!Config_.Replay.empty()) return true;
+
+    // Requests are sent once the connection is open
+    auto& Subscriptions = Reg_.ctx<SubscriptionManager>();
+    if (Config_.IsBinary) Subscriptions.setWireFormat(true);
+    Subscriptions.subscribe("sub_galaxy_data_evt");
+    Subscriptions.subscribe("sub_dynamic_data_evt");
+    Subscriptions.subscribe("sub_perf_stats_s1");
+    Subscriptions.subscribe("sub_sim_stats_s01");
+    return true;
+}
+
+void HeadlessClient::run()
+{
+    auto& Ingest = Reg_.ctx<IngestManager>();
+    auto& Network = Reg_.ctx<NetworkManager>();
+    auto& Parser = Reg_.ctx<ParserManager>();
+    auto& Renderer = Reg_.ctx<RenderSystem>();
+
+    const auto Step = std::chrono::duration<double>(1.0 / Config_.Rate);
+    auto Next = std::chrono::steady_clock::now();
+    Timer RunTimer;
+    Timer FrameTimer;
+
+    while (!IsInterrupted && RunTimer.split() < Config_.Duration)
+    {
+        FrameTimer.start();
+
+        Network.processLog();
+        Network.processReconnect();
+        if (IsConnectionLostEventTriggered_)
+        {
+            Ingest.markStale();
+            IsConnectionLostEventTriggered_.store(false);
+        }
+        if (IsReconnectEventTriggered_)
+        {
+            Reg_.ctx<SubscriptionManager>().resume();
+            Ingest.resume();
+            Reg_.ctx<InterestSystem>().reset();
+            Reg_.ctx<ClockSync>().reset();
+            IsReconnectEventTriggered_.store(false);
+        }
+
+        Ingest.getObjectsFromQueue();
+        StageQueue_.add(Timers_.Queue.elapsed());
+
+        if (IsDisconnectEventTriggered_)
+        {
+            Ingest.cleanupScene();
+            Reg_.ctx<SubscriptionManager>().clear();
+            Reg_.ctx<InterestSystem>().reset();
+            Reg_.ctx<ClockSync>().reset();
+            Reg_.ctx<SnapshotSystem>().reset();
+            IsDisconnectEventTriggered_.store(false);
+        }
+
+        auto& Motion = Reg_.ctx<MotionSystem>();
+        Motion.process();
+        if (Motion.isEnabled()) StageMotion_.add(Timers_.Motion.elapsed());
+        Reg_.ctx<SnapshotSystem>().process();
+        StageSnapshot_.add(Timers_.Snapshot.elapsed());
+
+        this->updateCamera(RunTimer.split());
+        Renderer.clampZoom();
+        Renderer.testViewportGalaxy();
+        Reg_.ctx<InterestSystem>().process();
+        StageViewport_.add(Timers_.ViewportTest.elapsed());
+
+        FrameTimer.stop();
+        StageFrame_.add(FrameTimer.elapsed());
+
+        // A replay ends once all of its messages were applied
+        if (!Config_.Replay.empty() && !Network.isReplaying() &&
+            Parser.getQueueDepth() == 0 && Timers_.QueueDeferred == 0) break;
+
+        Reg_.ctx<ClockSync>().process();
+        // End of tick, requests of this frame are sent if batching
+        OutputQueue_.flush();
+
+        Next += std::chrono::duration_cast<std::chrono::steady_clock::duration>(Step);
+        std::this_thread::sleep_until(Next);
+    }
+    ObjectsInsideViewport_ = Reg_.view<InsideViewportTag>().size();
+
+    Network.quit();
+    Parser.quit();
+}
+
+void HeadlessClient::printStats() const
+{
+    const auto& Network = Reg_.ctx<NetworkManager>();
+
+    auto print = [](const char* _Name, const Stage& _s)
+    {
+        std::printf("  %-16s avg %9.3f ms   max %9.3f ms\n", _Name, _s.avg()*1000.0, _s.Max*1000.0);
+    };
+
+    std::printf("Frames: %lu\n", static_cast<unsigned long>(StageFrame_.n));
+    std::printf("Stages:\n");
+    print("Frame", StageFrame_);
+    print("Queue", StageQueue_);
+    print("Interpolation", StageMotion_);
+    print("Snapshot", StageSnapshot_);
+    print("Viewport test", StageViewport_);
+    for (auto i=0; i<Timers_.ParseWorkers.load(); ++i)
+    {
+        std::printf("  Parse worker %d   avg %9.3f ms (last 50)\n", i, Timers_.ParseAvg[i].load()*1000.0);
+    }
+    std::printf("Queue:\n");
+    std::printf("  Coalesced          %lu\n", static_cast<unsigned long>(Timers_.QueueCoalesced));
+    std::printf("  Keyframe requests  %lu\n", static_cast<unsigned long>(Timers_.QueueKeyframeRequests));
+    std::printf("  Parse allocations  %lu\n", static_cast<unsigned long>(Timers_.ParseAllocations.load()));
+    std::printf("  Deferred at exit   %lu\n", static_cast<unsigned long>(Timers_.QueueDeferred));
+    std::printf("Network:\n");
+    std::printf("  Messages in        %lu\n", static_cast<unsigned long>(Network.getStats().MessagesIn.load()));
+    std::printf("  Messages out       %lu (%lu frames)\n", static_cast<unsigned long>(Network.getStats().MessagesOut.load()),
+                static_cast<unsigned long>(Network.getStats().FramesOut.load()));
+    std::printf("  Send latency       avg %.3f ms (last 50), max %.3f ms\n",
+                Network.getStats().SendLatencyAvg.load()*1000.0, Network.getStats().SendLatencyMax.load()*1000.0);
+    std::printf("  Received (raw)     %.3f MiB\n", Network.getStats().BytesRaw.load() / (1024.0*1024.0));
+    std::printf("  Received (wire)    %.3f MiB\n", Network.getBytesWire() / (1024.0*1024.0));
+    std::printf("  Sent               %.3f MiB\n", Network.getStats().BytesOut.load() / (1024.0*1024.0));
+    std::printf("  Largest message    in %.1f KiB, out %.1f KiB\n",
+                Network.getStats().MessageSizeInMax.load() / 1024.0,
+                Network.getStats().MessageSizeOutMax.load() / 1024.0);
+    std::printf("  Send errors        %lu\n", static_cast<unsigned long>(Network.getStats().SendErrors.load()));
+    std::printf("  Interest updates   %lu\n", static_cast<unsigned long>(Reg_.ctx<InterestSystem>().getUpdates()));
+    const auto& Clock = Reg_.ctx<ClockSync>();
+    if (Clock.isSynced())
+    {
+        std::printf("  Clock offset       %.3f ms, round trip %.3f ms\n",
+                    Clock.getOffset()*1000.0, Clock.getRoundTrip()*1000.0);
+        std::printf("  Staleness          %.3f ms (oldest %.3f ms, last 50 frames)\n",
+                    Clock.getStaleness()*1000.0, Clock.getStalenessOldest()*1000.0);
+    }
+    else
+    {
+        std::printf("  Clock              not synchronised\n");
+    }
+    std::printf("Requests (round trip):\n");
+    for (const auto& Method : Reg_.ctx<RequestTracker>().getStats())
+    {
+        std::printf("  %-24s n %6lu   avg %9.3f ms   p50 %9.3f ms   p99 %9.3f ms   max %9.3f ms   "
+                    "errors %lu   timeouts %lu\n", Method.Name.c_str(), static_cast<unsigned long>(Method.Count),
+                    Method.getAvg()*1000.0, Method.getPercentile(0.5)*1000.0, Method.getPercentile(0.99)*1000.0,
+                    Method.Max*1000.0, static_cast<unsigned long>(Method.Errors),
+                    static_cast<unsigned long>(Method.Timeouts));
+    }
+    std::printf("Scene:\n");
+    std::printf("  Objects            %lu\n", static_cast<unsigned long>(Reg_.ctx<IngestManager>().getObjectCount()));
+    std::printf("  Inside viewport    %lu\n", static_cast<unsigned long>(ObjectsInsideViewport_));
+    std::printf("  Stale              %lu\n", static_cast<unsigned long>(Reg_.ctx<IngestManager>().getStaleCount()));
+    const auto& Snapshots = Reg_.ctx<SnapshotSystem>().getRing();
+    std::printf("Snapshots:\n");
+    std::printf("  Recorded           %lu of %lu (%.2f s)\n", static_cast<unsigned long>(Snapshots.size()),
+                static_cast<unsigned long>(Snapshots.getCapacity()),
+                Snapshots.empty() ? 0.0 : Reg_.ctx<SnapshotSystem>().getAge(0));
+    std::printf("  Records            %lu of %lu (%.3f MiB)\n", static_cast<unsigned long>(Snapshots.getRecords()),
+                static_cast<unsigned long>(Snapshots.getRecordCapacity()), Snapshots.getMemory() / (1024.0*1024.0));
+    std::printf("  Truncated          %lu\n", static_cast<unsigned long>(Snapshots.getTruncated()));
+}
+
+void HeadlessClient::updateCamera(double _t)
+{
+    if (!Config_.IsZoomSweep) return;
+
+    // Zoom in and out by one decade per second, starting from the given
+    // zoom, like scrolling the mouse wheel in the desktop client
+    auto& Zoom = Reg_.get<ZoomComponent>(Reg_.ctx<RenderSystem>().getCamera());
+    if (Zoom.c == 0)
+    {
+        const double Decade = std::fmod(_t, 8.0);
+        const double ZoomSpeed = (Decade < 4.0) ? 10.0 : 0.1;
+        Zoom.t = Zoom.z * std::pow(ZoomSpeed, 1.0/Config_.Rate * Zoom.s);
+        Zoom.i = (Zoom.t - Zoom.z) / Zoom.s;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    argagg::parser ArgParser
+    {{
+        {"batch", {"--batch"}, "Send requests of a frame as JSON-RPC batch, if the server supports it", 0},
+        {"binary", {"-b", "--binary"}, "Request the binary wire format", 0},
+        {"duration", {"-d", "--duration"}, "Run time in seconds (default: 10)", 1},
+        {"galaxy_cache", {"--galaxy-cache"}, "Galaxy cache file (default: galaxy.cache)", 1},
+        {"help", {"-h", "--help"}, "Show this help message", 0},
+        {"no_interest", {"--no-interest"}, "Receive all dynamic objects instead of those near the viewport", 0},
+        {"no_interpolation", {"--no-interpolation"}, "Show dynamic objects at the latest position received", 0},
+        {"rate", {"-r", "--rate"}, "Frame rate in Hz (default: 60)", 1},
+        {"record", {"--record"}, "Record received messages to the given session log", 1},
+        {"replay", {"--replay"}, "Replay the given session log instead of connecting", 1},
+        {"replay_speed", {"--replay-speed"},
+         "Replay speed as factor of the recorded rate, 0 is as fast as possible (default: 1)", 1},
+        {"server", {"-s", "--server"}, "Server to connect to (default: ws://localhost:9002/?id=1)", 1},
+        {"size", {"--size"}, "Viewport size in pixels as <width>x<height> (default: 1024x768)", 1},
+        {"snapshot_memory", {"--snapshot-memory"}, "Memory of the snapshot history in MiB (default: 64)", 1},
+        {"snapshot_seconds", {"--snapshot-seconds"}, "Seconds of the snapshot history (default: 30)", 1},
+        {"zoom", {"-z", "--zoom"}, "Camera zoom (default: 1e-16)", 1},
+        {"zoom_sweep", {"--zoom-sweep"}, "Zoom in and out continuously", 0}
+    }};
+
+    argagg::parser_results Args;
+    try
+    {
+        Args = ArgParser.parse(argc, argv);
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    if (Args["help"])
+    {
+        std::cout << "pwng-headless: desktop client without window, for profiling and CI" << std::endl
+                  << ArgParser;
+        return EXIT_SUCCESS;
+    }
+
+    HeadlessClient::Config Config;
+    Config.CacheFile = Args["galaxy_cache"].as<std::string>(Config.CacheFile);
+    Config.IsBinary = Args["binary"];
+    Config.IsBatching = Args["batch"];
+    Config.IsInterest = !Args["no_interest"];
+    Config.IsInterpolation = !Args["no_interpolation"];
+    Config.Duration = Args["duration"].as<double>(Config.Duration);
+    Config.Rate = Args["rate"].as<double>(Config.Rate);
+    Config.Record = Args["record"].as<std::string>("");
+    Config.Replay = Args["replay"].as<std::string>("");
+    Config.ReplaySpeed = Args["replay_speed"].as<double>(Config.ReplaySpeed);
+    Config.Server = Args["server"].as<std::string>(Config.Server);
+    Config.SnapshotMemory = Args["snapshot_memory"].as<double>(Config.SnapshotMemory);
+    Config.SnapshotSeconds = Args["snapshot_seconds"].as<double>(Config.SnapshotSeconds);
+    Config.Zoom = Args["zoom"].as<double>(Config.Zoom);
+    Config.IsZoomSweep = Args["zoom_sweep"];
+    if (Args["size"])
+    {
+        const auto Size = Args["size"].as<std::string>();
+        if (std::sscanf(Size.c_str(), "%dx%d", &Config.Width, &Config.Height) != 2)
+        {
+            std::cerr << "Invalid viewport size " << Size << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::signal(SIGINT, [](int){IsInterrupted.store(true);});
+
+    HeadlessClient Client;
+    if (!Client.init(Config)) return EXIT_FAILURE;
+    Client.run();
+    Client.printStats();
+
+    return EXIT_SUCCESS;
+}
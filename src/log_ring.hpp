@@ -0,0 +1,108 @@
+#ifndef LOG_RING_HPP
+#define LOG_RING_HPP
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+// Bounded lock-free ring of fixed size log records, for threads that must
+// neither block nor allocate when logging (e.g. the websocket client
+// thread). Multiple producers, a single consumer draining the records.
+// Each slot carries a sequence number telling whether it is free for the
+// producer of the given position or ready for the consumer (see Vyukov's
+// bounded MPMC queue). Records are dropped if the ring is full, long
+// messages are truncated.
+class LogRing
+{
+
+    public:
+
+        static constexpr std::size_t CAPACITY = 256; // Power of 2
+        static constexpr std::size_t TEXT_SIZE = 240;
+
+        struct Record
+        {
+            std::uint32_t Channel{0};
+            std::uint16_t Length{0};
+            bool IsError{false};
+            char Text[TEXT_SIZE];
+        };
+
+        LogRing()
+        {
+            for (auto i=0u; i<CAPACITY; ++i) Slots_[i].Sequence.store(i, std::memory_order_relaxed);
+        }
+        LogRing(const LogRing&) = delete;
+        LogRing& operator=(const LogRing&) = delete;
+
+        bool push(bool _IsError, std::uint32_t _Channel, const char* _Text, std::size_t _Length)
+        {
+            std::size_t Pos = Head_.load(std::memory_order_relaxed);
+            Slot* s{nullptr};
+            while (true)
+            {
+                s = &Slots_[Pos & (CAPACITY-1)];
+                const std::size_t Seq = s->Sequence.load(std::memory_order_acquire);
+                const auto Diff = static_cast<std::intptr_t>(Seq) - static_cast<std::intptr_t>(Pos);
+                if (Diff == 0)
+                {
+                    // Claim position, on failure Pos holds the current head
+                    if (Head_.compare_exchange_weak(Pos, Pos+1, std::memory_order_relaxed)) break;
+                }
+                else if (Diff < 0)
+                {
+                    // Consumer didn't free this slot yet, ring is full
+                    Dropped_.fetch_add(1, std::memory_order_relaxed);
+                    return false;
+                }
+                else
+                {
+                    Pos = Head_.load(std::memory_order_relaxed);
+                }
+            }
+            if (_Length > TEXT_SIZE) _Length = TEXT_SIZE;
+            s->Rec.Channel = _Channel;
+            s->Rec.Length = static_cast<std::uint16_t>(_Length);
+            s->Rec.IsError = _IsError;
+            std::memcpy(s->Rec.Text, _Text, _Length);
+            s->Sequence.store(Pos+1, std::memory_order_release);
+            return true;
+        }
+
+        // Calls _f(const Record&) for all records ready, in order. Must not
+        // be called by more than one thread
+        template<class Func>
+        std::size_t drain(Func _f)
+        {
+            std::size_t n{0};
+            while (true)
+            {
+                Slot& s = Slots_[Tail_ & (CAPACITY-1)];
+                if (s.Sequence.load(std::memory_order_acquire) != Tail_+1) break;
+                _f(s.Rec);
+                s.Sequence.store(Tail_+CAPACITY, std::memory_order_release);
+                ++Tail_;
+                ++n;
+            }
+            return n;
+        }
+
+        std::uint64_t getDropped() const {return Dropped_.load(std::memory_order_relaxed);}
+
+    private:
+
+        struct Slot
+        {
+            std::atomic<std::size_t> Sequence{0};
+            Record Rec;
+        };
+
+        // Producers and consumer on separate cache lines
+        alignas(64) std::atomic<std::size_t> Head_{0};
+        alignas(64) std::size_t Tail_{0};
+        alignas(64) std::array<Slot, CAPACITY> Slots_;
+        std::atomic<std::uint64_t> Dropped_{0};
+};
+
+#endif // LOG_RING_HPP
@@ -0,0 +1,123 @@
+#include "clock_sync.hpp"
+
+#include <algorithm>
+
+#include "ingest_manager.hpp"
+#include "json_manager.hpp"
+#include "message_handler.hpp"
+#include "network_manager.hpp"
+#include "request_tracker.hpp"
+
+void ClockSync::process()
+{
+    const double Now = ClockSync::getClientTime();
+
+    if (UpdateTimeMax_ >= UpdateTimeMin_)
+    {
+        if (IsSynced_)
+        {
+            // Client time the updates were emitted at
+            Staleness_.addValue(Now - this->toClientTime(UpdateTimeMax_));
+            StalenessOldest_.addValue(Now - this->toClientTime(UpdateTimeMin_));
+        }
+        UpdateTimeMin_ = std::numeric_limits<double>::max();
+        UpdateTimeMax_ = std::numeric_limits<double>::lowest();
+    }
+
+    if (!IsSupported_ || Now < PingNext_) return;
+    if (!Reg_.ctx<NetworkManager>().isConnected()) return;
+
+    this->sendPing();
+    PingNext_ = Now + PING_PERIOD;
+}
+
+void ClockSync::reset()
+{
+    SampleCount_ = 0;
+    SampleNext_ = 0;
+    IsSynced_ = false;
+    IsSupported_ = true;
+    PingNext_ = 0.0;
+}
+
+double ClockSync::getServerTime() const
+{
+    return Acceleration_ * (ClockSync::getClientTime() + Offset_);
+}
+
+double ClockSync::getClientTime()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void ClockSync::onPong(double _t0, double _t1, double _t2, double _Acceleration)
+{
+    // Applied up to a frame after reception
+    const double t3 = Reg_.ctx<IngestManager>().getDocumentTime();
+
+    // A paused simulation has no clock to synchronise to
+    if (_Acceleration <= 0.0) return;
+    if (_Acceleration != Acceleration_)
+    {
+        SampleCount_ = 0;
+        SampleNext_ = 0;
+        Acceleration_ = _Acceleration;
+    }
+    const double t1 = _t1 / _Acceleration;
+    const double t2 = _t2 / _Acceleration;
+
+    Sample s;
+    s.Offset = 0.5 * ((t1 - _t0) + (t2 - t3));
+    s.RoundTrip = std::max((t3 - _t0) - (t2 - t1), 0.0);
+    Samples_[SampleNext_] = s;
+    SampleNext_ = (SampleNext_ + 1) % SAMPLES;
+    SampleCount_ = std::min(SampleCount_ + 1, SAMPLES);
+
+    auto Best = std::min_element(Samples_.begin(), Samples_.begin() + SampleCount_,
+                                 [](const Sample& _a, const Sample& _b) {return _a.RoundTrip < _b.RoundTrip;});
+    Offset_ = Best->Offset;
+    RoundTrip_ = Best->RoundTrip;
+    IsSynced_ = true;
+}
+
+void ClockSync::sendPing()
+{
+    auto& Json = Reg_.ctx<JsonManager>();
+
+    // Delays on one leg only bias the offset. Hence, the ping is sent right
+    // away, even if requests are batched until the end of the frame, and
+    // the pong is stamped with its time of reception (see onPong)
+    const double t0 = ClockSync::getClientTime();
+    const auto Id = Json.createRequest("cmd_ping")
+        .addParam("t0", t0)
+        .finalise();
+    OutputQueue_->enqueue(Json.getString());
+    OutputQueue_->flush();
+
+    auto& Tracker = Reg_.ctx<RequestTracker>();
+    Tracker.track(Id, "cmd_ping");
+    Tracker.onResponse(Id,
+        [this, t0](RequestTracker::StatusE _Status, const rapidjson::Value& _Response)
+        {
+            if (_Status == RequestTracker::StatusE::SUCCESS)
+            {
+                if (!_Response.IsObject()) return;
+                auto t1 = _Response.FindMember("t1");
+                auto t2 = _Response.FindMember("t2");
+                auto a = _Response.FindMember("ts_f");
+                if (t1 == _Response.MemberEnd() || t2 == _Response.MemberEnd()) return;
+                this->onPong(t0, t1->value.GetDouble(), t2->value.GetDouble(),
+                             a != _Response.MemberEnd() ? a->value.GetDouble() : 1.0);
+            }
+            else if (_Status == RequestTracker::StatusE::ERROR && IsSupported_ && _Response.IsObject())
+            {
+                auto Code = _Response.FindMember("code");
+                if (Code != _Response.MemberEnd() && Code->value == -32601)
+                {
+                    IsSupported_ = false;
+                    Reg_.ctx<MessageHandler>().report("net", "Server doesn't support clock synchronisation",
+                                                      MessageHandler::INFO);
+                }
+            }
+        });
+}
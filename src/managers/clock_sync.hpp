@@ -0,0 +1,106 @@
+#ifndef CLOCK_SYNC_HPP
+#define CLOCK_SYNC_HPP
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <limits>
+
+#include <entt/entity/registry.hpp>
+
+#include "avg_filter.hpp"
+#include "network_message.hpp"
+
+// Estimates the offset between the client's clock and the server's
+// simulation clock with an NTP-style exchange (cmd_ping), to measure how old
+// the rendered state is.
+//
+// The server answers a ping with its simulation time on reception (t1) and
+// on sending (t2) as well as the acceleration of the simulation. With the
+// client's send (t0) and receive (t3) times, scaled to the client's rate:
+//   offset     = ((t1 - t0) + (t2 - t3)) / 2
+//   round trip = (t3 - t0) - (t2 - t1)
+// The sample with the smallest round trip of the last SAMPLES is used, as
+// it is the least affected by asymmetric queueing. Acceleration is assumed
+// to be constant between pings, samples are dropped if it changes.
+//
+// Updates carry the simulation time they were emitted at, thus staleness is
+// the time from emission by the server to presenting the frame the update
+// was applied in.
+class ClockSync
+{
+
+    public:
+
+        static constexpr double PING_PERIOD = 2.0;
+        static constexpr std::size_t SAMPLES = 8;
+
+        explicit ClockSync(entt::registry& _Reg) : Reg_(_Reg) {}
+
+        void init(OutgoingQueue* const _OutputQueue) {OutputQueue_ = _OutputQueue;}
+
+        // Server simulation time of an applied update
+        void addUpdate(double _t)
+        {
+            if (_t < UpdateTimeMin_) UpdateTimeMin_ = _t;
+            if (_t > UpdateTimeMax_) UpdateTimeMax_ = _t;
+        }
+        // Send pings and measure staleness of this frame's updates. To be
+        // called once per frame, right before it is presented
+        void process();
+        // Server clock unknown, e.g. new session or reconnected
+        void reset();
+
+        bool isSupported() const {return IsSupported_;}
+        bool isSynced() const {return IsSynced_;}
+        // Simulation seconds per client second
+        double getAcceleration() const {return Acceleration_;}
+        double getOffset() const {return Offset_;}
+        double getRoundTrip() const {return RoundTrip_;}
+        // Estimated server simulation time now
+        double getServerTime() const;
+        // Client time of the given server simulation time
+        double toClientTime(double _t) const {return _t / Acceleration_ - Offset_;}
+        // Monotonic client time in seconds
+        static double getClientTime();
+        // Staleness of the newest and oldest update of a frame
+        double getStaleness() const {return Staleness_.getAvg();}
+        double getStalenessOldest() const {return StalenessOldest_.getAvg();}
+
+    private:
+
+        struct Sample
+        {
+            double Offset{0.0};
+            double RoundTrip{0.0};
+        };
+
+        void onPong(double _t0, double _t1, double _t2, double _Acceleration);
+        void sendPing();
+
+        entt::registry& Reg_;
+
+        OutgoingQueue* OutputQueue_{nullptr};
+
+        std::array<Sample, SAMPLES> Samples_;
+        std::size_t SampleCount_{0};
+        std::size_t SampleNext_{0};
+
+        double Acceleration_{1.0};
+        double Offset_{0.0};
+        double RoundTrip_{0.0};
+        bool IsSynced_{false};
+        // Cleared if the server doesn't know the method
+        bool IsSupported_{true};
+
+        double PingNext_{0.0};
+
+        // Updates applied since the last frame
+        double UpdateTimeMin_{std::numeric_limits<double>::max()};
+        double UpdateTimeMax_{std::numeric_limits<double>::lowest()};
+
+        AvgFilter<double> Staleness_{50};
+        AvgFilter<double> StalenessOldest_{50};
+};
+
+#endif // CLOCK_SYNC_HPP
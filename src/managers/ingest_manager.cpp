@@ -0,0 +1,867 @@
+#include "ingest_manager.hpp"
+
+#include <array>
+#include <chrono>
+
+#include "binary_message.hpp"
+#include "clock_sync.hpp"
+#include "galaxy_cache.hpp"
+#include "json_manager.hpp"
+#include "message_handler.hpp"
+#include "method_dispatcher.hpp"
+#include "name_system.hpp"
+#include "parser_manager.hpp"
+#include "request_tracker.hpp"
+
+void IngestManager::init(OutgoingQueue* const _OutputQueue)
+{
+    OutputQueue_ = _OutputQueue;
+    this->setupHandlers();
+}
+
+void IngestManager::applyBinary(const std::string& _Data)
+{
+    auto& Messages = Reg_.ctx<MessageHandler>();
+
+    BinaryReader Reader(_Data.data(), _Data.size());
+    BinaryHeader Header;
+    if (!Reader.readHeader(Header))
+    {
+        Messages.report("prg", "Invalid binary message header, ignoring", MessageHandler::WARNING);
+        return;
+    }
+    // Galaxy transfers announce the number of new objects, grow id map once
+    if (Header.Type == BinaryMessageE::GALAXY_STARS || Header.Type == BinaryMessageE::GALAXY_SYSTEMS)
+    {
+        Id2EntityMap_.reserve(Id2EntityMap_.size() + Header.Count);
+    }
+    else if (Header.hasTime() && Header.Count > 0)
+    {
+        Reg_.ctx<ClockSync>().addUpdate(Header.Time);
+    }
+
+    std::array<double, 2*TireComponent::SEGMENTS> Rubber;
+    for (auto i=0u; i<Header.Count; ++i)
+    {
+        std::uint32_t Id{0};
+        const char* Name{nullptr};
+        std::size_t NameLength{0};
+        double m{0.0}, r{0.0}, spx{0.0}, spy{0.0}, px{0.0}, py{0.0}, t{0.0};
+        std::int32_t SC{0};
+
+        bool IsValid = Reader.read(Id);
+        switch (Header.Type)
+        {
+            case BinaryMessageE::DYNAMIC_DATA:
+            {
+                DynamicUpdate u;
+                u.Eid = Id;
+                u.Fields = DynamicUpdate::FIELDS_ALL;
+                u.t = Header.Time;
+                u.HasTime = Header.hasTime();
+                IsValid = IsValid && Reader.read(u.m) && Reader.read(u.r) &&
+                          Reader.read(u.spx) && Reader.read(u.spy) &&
+                          Reader.read(u.px) && Reader.read(u.py) &&
+                          Reader.readName(u.Name, u.NameLength);
+                if (IsValid) this->applyDynamicUpdate(u);
+                break;
+            }
+            case BinaryMessageE::DYNAMIC_DELTA:
+            {
+                DynamicUpdate u;
+                u.Eid = Id;
+                u.HasSeq = true;
+                u.t = Header.Time;
+                u.HasTime = Header.hasTime();
+                IsValid = IsValid && Reader.read(u.Seq) && Reader.read(u.Fields);
+                if (IsValid && (u.Fields & DynamicUpdate::FIELD_MASS))
+                    IsValid = Reader.read(u.m);
+                if (IsValid && (u.Fields & DynamicUpdate::FIELD_RADIUS))
+                    IsValid = Reader.read(u.r);
+                if (IsValid && (u.Fields & DynamicUpdate::FIELD_SYSTEM_POSITION))
+                    IsValid = Reader.read(u.spx) && Reader.read(u.spy);
+                if (IsValid && (u.Fields & DynamicUpdate::FIELD_POSITION))
+                    IsValid = Reader.read(u.px) && Reader.read(u.py);
+                if (IsValid && (u.Fields & DynamicUpdate::FIELD_NAME))
+                    IsValid = Reader.readName(u.Name, u.NameLength);
+                if (IsValid) this->applyDynamicUpdate(u);
+                break;
+            }
+            case BinaryMessageE::GALAXY_STARS:
+                IsValid = IsValid && Reader.read(SC) && Reader.read(m) && Reader.read(r) &&
+                          Reader.read(spx) && Reader.read(spy) && Reader.read(t) &&
+                          Reader.readName(Name, NameLength);
+                if (IsValid) this->applyStar(Id, Name, NameLength, m, r, spx, spy, SpectralClassE(SC), t);
+                break;
+            case BinaryMessageE::GALAXY_SYSTEMS:
+                IsValid = IsValid && Reader.readName(Name, NameLength);
+                if (IsValid) this->applySystem(Id, Name, NameLength);
+                break;
+            case BinaryMessageE::TIRE_DATA:
+                IsValid = IsValid && Reader.read(px) && Reader.read(py) && Reader.read(r);
+                for (auto j=0u; j<Rubber.size() && IsValid; ++j) IsValid = Reader.read(Rubber[j]);
+                if (IsValid) this->applyTire(Id, px, py, r, Rubber.data());
+                break;
+            default:
+                IsValid = false;
+        }
+        if (!IsValid)
+        {
+            Messages.report("prg", "Truncated or unknown binary message, ignoring rest", MessageHandler::WARNING);
+            return;
+        }
+    }
+}
+
+void IngestManager::applyDynamicUpdate(const DynamicUpdate& _u)
+{
+    if (StaleObjects_.IsPending && !StaleObjects_.Updated.insert(_u.Eid).second)
+        this->purgeStale<MotionComponent>(StaleObjects_);
+
+    auto Existing = Id2EntityMap_.find(_u.Eid);
+    if (Existing != entt::null)
+    {
+        Reg_.remove<StaleTag>(Existing);
+        if (_u.HasSeq)
+        {
+            auto& Seq = Reg_.get_or_emplace<SequenceComponent>(Existing);
+            if (_u.isKeyframe())
+            {
+                Seq.IsKeyframeRequested = false;
+            }
+            else if (_u.Seq != Seq.Seq+1 && !Seq.IsKeyframeRequested)
+            {
+                // Base of this delta got lost, fields are absolute values, hence
+                // still apply it but resynchronise the remaining ones
+                this->requestKeyframe(_u.Eid);
+                Seq.IsKeyframeRequested = true;
+            }
+            Seq.Seq = _u.Seq;
+        }
+
+        // Only touch components of fields that changed
+        if (_u.Fields & DynamicUpdate::FIELD_MASS)
+            Reg_.emplace_or_replace<MassComponent>(Existing, _u.m);
+        if (_u.Fields & DynamicUpdate::FIELD_POSITION)
+        {
+            Reg_.emplace_or_replace<PositionComponent>(Existing, _u.px, _u.py);
+            // Positions relative to another system can't be interpolated
+            // with those before
+            bool IsSystemChanged{false};
+            if (_u.Fields & DynamicUpdate::FIELD_SYSTEM_POSITION)
+            {
+                const auto& System = Reg_.get<SystemPositionComponent>(Existing);
+                IsSystemChanged = (System.x != _u.spx || System.y != _u.spy);
+            }
+            this->addMotion(Existing, _u, IsSystemChanged);
+        }
+        if (_u.Fields & DynamicUpdate::FIELD_RADIUS)
+            Reg_.emplace_or_replace<RadiusComponent>(Existing, _u.r);
+        if (_u.Fields & DynamicUpdate::FIELD_SYSTEM_POSITION)
+            Reg_.emplace_or_replace<SystemPositionComponent>(Existing, _u.spx, _u.spy);
+        if (_u.Fields & DynamicUpdate::FIELD_NAME)
+            NameSystem::copyName(Reg_.emplace_or_replace<NameComponent>(Existing), _u.Name, _u.NameLength);
+        // DBLK(Messages.report("prg", "Entity components updated", MessageHandler::DEBUG_L3);)
+    }
+    else if (!_u.isKeyframe() || (_u.Fields & DynamicUpdate::FIELDS_ALL) != DynamicUpdate::FIELDS_ALL)
+    {
+        // A delta of an unknown object can't be applied without its base
+        this->requestKeyframe(_u.Eid);
+    }
+    else
+    {
+        auto e = Reg_.create();
+        Reg_.emplace<MassComponent>(e, _u.m);
+        Reg_.emplace<PositionComponent>(e, _u.px, _u.py);
+        this->addMotion(e, _u, true);
+        Reg_.emplace<RadiusComponent>(e, _u.r);
+        Reg_.emplace<SystemPositionComponent>(e, _u.spx, _u.spy);
+        NameSystem::copyName(Reg_.emplace<NameComponent>(e), _u.Name, _u.NameLength);
+        if (_u.HasSeq) Reg_.emplace<SequenceComponent>(e, _u.Seq);
+        this->notifyNewObject(e, std::string(_u.Name, _u.NameLength));
+        IsNewHooks_ = true;
+        Id2EntityMap_.insert(_u.Eid, e);
+        // DBLK(Messages.report("prg", "Entity created", MessageHandler::DEBUG_L2);)
+    }
+}
+
+void IngestManager::addMotion(entt::entity _e, const DynamicUpdate& _u, bool _IsReset)
+{
+    ++PositionUpdates_;
+
+    // Without server time, the time of reception is used
+    const auto& Clock = Reg_.ctx<ClockSync>();
+    const double t = (_u.HasTime && Clock.isSynced()) ? Clock.toClientTime(_u.t) : DocumentTime_;
+
+    auto* Motion = Reg_.try_get<MotionComponent>(_e);
+    if (Motion == nullptr || _IsReset)
+    {
+        Reg_.emplace_or_replace<MotionComponent>(_e, t, _u.px, _u.py, t, _u.px, _u.py);
+        return;
+    }
+    // Received at about the same time (e.g. deltas of one batch) or out of
+    // order, the latest position wins. Interpolating over a tiny interval
+    // would make extrapolation overshoot
+    if (t - Motion->t1 < MOTION_INTERVAL_MIN)
+    {
+        Motion->x1 = _u.px;
+        Motion->y1 = _u.py;
+        return;
+    }
+    *Motion = {Motion->t1, Motion->x1, Motion->y1, t, _u.px, _u.py};
+}
+
+void IngestManager::applyStar(entt::id_type _Id, const char* _Name, std::size_t _NameLength,
+                           double _m, double _r, double _spx, double _spy, SpectralClassE _SC, double _t)
+{
+    auto Existing = Id2EntityMap_.find(_Id);
+    if (Existing != entt::null)
+    {
+        Reg_.remove<StaleTag>(Existing);
+        Reg_.emplace_or_replace<RadiusComponent>(Existing, _r);
+        Reg_.emplace_or_replace<MassComponent>(Existing, _m);
+        Reg_.emplace_or_replace<SystemPositionComponent>(Existing, _spx, _spy);
+        Reg_.emplace_or_replace<StarDataComponent>(Existing, _SC, _t);
+        NameSystem::copyName(Reg_.emplace_or_replace<NameComponent>(Existing), _Name, _NameLength);
+        // DBLK(Messages.report("prg", "Entity components updated", MessageHandler::DEBUG_L3);)
+    }
+    else
+    {
+        auto e = Reg_.create();
+        Reg_.emplace<RadiusComponent>(e, _r);
+        Reg_.emplace<MassComponent>(e, _m);
+        Reg_.emplace<SystemPositionComponent>(e, _spx, _spy);
+        Reg_.emplace<StarDataComponent>(e, _SC, _t);
+        NameSystem::copyName(Reg_.emplace<NameComponent>(e), _Name, _NameLength);
+        this->notifyNewObject(e, std::string(_Name, _NameLength));
+        Id2EntityMap_.insert(_Id, e);
+        ++GalaxyStarsReceived_;
+        // DBLK(Messages.report("prg", "Entity created", MessageHandler::DEBUG_L2);)
+    }
+}
+
+void IngestManager::applySystem(entt::id_type _Id, const char* _Name, std::size_t _NameLength)
+{
+    auto Existing = Id2EntityMap_.find(_Id);
+    if (Existing != entt::null)
+    {
+        Reg_.remove<StaleTag>(Existing);
+        Reg_.emplace_or_replace<StarSystemTag>(Existing);
+        NameSystem::copyName(Reg_.emplace_or_replace<NameComponent>(Existing), _Name, _NameLength);
+        // DBLK(Messages.report("prg", "Entity components updated", MessageHandler::DEBUG_L3);)
+    }
+    else
+    {
+        auto e = Reg_.create();
+        Reg_.emplace<StarSystemTag>(e);
+        NameSystem::copyName(Reg_.emplace<NameComponent>(e), _Name, _NameLength);
+        this->notifyNewSystem(e, std::string(_Name, _NameLength));
+        Id2EntityMap_.insert(_Id, e);
+        // DBLK(Messages.report("prg", "Entity created", MessageHandler::DEBUG_L2);)
+    }
+}
+
+void IngestManager::applyTire(entt::id_type _Id, double _RimX, double _RimY, double _RimR, const double* _Rubber)
+{
+    if (StaleTires_.IsPending && !StaleTires_.Updated.insert(_Id).second)
+        this->purgeStale<TireComponent>(StaleTires_);
+
+    auto Existing = Id2EntityMap_.find(_Id);
+    if (Existing != entt::null)
+    {
+        Reg_.remove<StaleTag>(Existing);
+        Reg_.emplace_or_replace<PositionComponent>(Existing, _RimX, _RimY);
+
+        auto& Tire = Reg_.emplace_or_replace<TireComponent>(Existing, _RimR);
+        for (auto i=0u; i<TireComponent::SEGMENTS; ++i)
+        {
+            Tire.RubberX[i] = _Rubber[i*2];
+            Tire.RubberY[i] = _Rubber[i*2+1];
+        }
+    }
+    else
+    {
+        auto e = Reg_.create();
+        auto& Tire = Reg_.emplace<TireComponent>(e, _RimX, _RimY, _RimR);
+
+        Reg_.emplace<SystemPositionComponent>(e, 0.0, 0.0);
+        Reg_.emplace<PositionComponent>(e, _RimX, _RimY);
+
+        for (auto i=0u; i<TireComponent::SEGMENTS; ++i)
+        {
+            Tire.RubberX[i] = _Rubber[i*2];
+            Tire.RubberY[i] = _Rubber[i*2+1];
+        }
+        this->notifyNewObject(e, "Tire");
+        IsNewHooks_ = true;
+        Id2EntityMap_.insert(_Id, e);
+    }
+}
+
+void IngestManager::applyGalaxyCache()
+{
+    auto& Cache = Reg_.ctx<GalaxyCache>();
+
+    const auto Stars = Cache.getStarCount();
+    const auto Systems = Cache.getSystemCount();
+    Id2EntityMap_.reserve(Id2EntityMap_.size() + Stars + Systems);
+
+    // Columns of the mapped file have the layout of the components
+    auto& b = StarBatch_;
+    b.Entities.resize(Stars);
+    Reg_.create(b.Entities.begin(), b.Entities.end());
+    Reg_.insert<MassComponent>(b.Entities.begin(), b.Entities.end(), Cache.getStarMasses());
+    Reg_.insert<NameComponent>(b.Entities.begin(), b.Entities.end(), Cache.getStarNames());
+    Reg_.insert<RadiusComponent>(b.Entities.begin(), b.Entities.end(), Cache.getStarRadii());
+    Reg_.insert<StarDataComponent>(b.Entities.begin(), b.Entities.end(), Cache.getStarData());
+    Reg_.insert<SystemPositionComponent>(b.Entities.begin(), b.Entities.end(), Cache.getStarPositions());
+    for (auto i=0u; i<Stars; ++i)
+    {
+        Id2EntityMap_.insert(Cache.getStarIds()[i], b.Entities[i]);
+        this->notifyNewObject(b.Entities[i], Cache.getStarNames()[i].Name);
+    }
+
+    b.Entities.resize(Systems);
+    Reg_.create(b.Entities.begin(), b.Entities.end());
+    Reg_.insert<StarSystemTag>(b.Entities.begin(), b.Entities.end());
+    Reg_.insert<NameComponent>(b.Entities.begin(), b.Entities.end(), Cache.getSystemNames());
+    for (auto i=0u; i<Systems; ++i)
+    {
+        Id2EntityMap_.insert(Cache.getSystemIds()[i], b.Entities[i]);
+        this->notifyNewSystem(b.Entities[i], Cache.getSystemNames()[i].Name);
+    }
+
+    for (auto l : ListenersGalaxyCached_) l(Cache.getVertices(), Cache.getVertexCount());
+    IsNewHooks_ = true;
+    IsGalaxyFromCache_ = true;
+}
+
+void IngestManager::applyGalaxyStarsBatch(const rapidjson::Value& _p)
+{
+    auto& Messages = Reg_.ctx<MessageHandler>();
+
+    const auto& Eids = _p["eid"];
+    const auto& Names = _p["name"];
+    const auto& Ms = _p["m"];
+    const auto& Xs = _p["spx"];
+    const auto& Ys = _p["spy"];
+    const auto& Rs = _p["r"];
+    const auto& SCs = _p["sc"];
+    const auto& Ts = _p["t"];
+
+    const auto n = Eids.Size();
+    if (Names.Size() != n || Ms.Size() != n || Xs.Size() != n || Ys.Size() != n ||
+        Rs.Size() != n || SCs.Size() != n || Ts.Size() != n)
+    {
+        Messages.report("prg", "Inconsistent column sizes in star batch, ignoring", MessageHandler::WARNING);
+        return;
+    }
+
+    // Grow id map once for the whole batch
+    Id2EntityMap_.reserve(Id2EntityMap_.size() + n);
+
+    auto& b = StarBatch_;
+    b.Ids.clear();
+    b.Index.clear();
+    b.Masses.clear();
+    b.Names.clear();
+    b.Positions.clear();
+    b.Radii.clear();
+    b.StarData.clear();
+
+    for (auto i=0u; i<n; ++i)
+    {
+        entt::id_type Id = Eids[i].GetUint();
+
+        auto Existing = Id2EntityMap_.find(Id);
+        if (Existing != entt::null)
+        {
+            Reg_.remove<StaleTag>(Existing);
+            Reg_.emplace_or_replace<RadiusComponent>(Existing, Rs[i].GetDouble());
+            Reg_.emplace_or_replace<MassComponent>(Existing, Ms[i].GetDouble());
+            Reg_.emplace_or_replace<SystemPositionComponent>(Existing, Xs[i].GetDouble(), Ys[i].GetDouble());
+            Reg_.emplace_or_replace<StarDataComponent>(Existing, SpectralClassE(SCs[i].GetInt()), Ts[i].GetDouble());
+            NameSystem::copyName(Reg_.emplace_or_replace<NameComponent>(Existing),
+                                 Names[i].GetString(), Names[i].GetStringLength());
+        }
+        else
+        {
+            // A star repeated within the batch replaces its earlier entry,
+            // otherwise it would be created twice
+            auto Repeated = b.Index.insert({Id, b.Ids.size()});
+            if (Repeated.second)
+            {
+                b.Ids.push_back(Id);
+                b.Masses.emplace_back();
+                b.Positions.emplace_back();
+                b.Radii.emplace_back();
+                b.StarData.emplace_back();
+                b.Names.emplace_back();
+            }
+            const auto j = Repeated.first->second;
+            b.Masses[j] = {Ms[i].GetDouble()};
+            b.Positions[j] = {Xs[i].GetDouble(), Ys[i].GetDouble()};
+            b.Radii[j] = {Rs[i].GetDouble()};
+            b.StarData[j] = {SpectralClassE(SCs[i].GetInt()), Ts[i].GetDouble()};
+            NameSystem::copyName(b.Names[j], Names[i].GetString(), Names[i].GetStringLength());
+        }
+    }
+
+    if (b.Ids.empty()) return;
+    GalaxyStarsReceived_ += b.Ids.size();
+
+    // Create all new stars at once and fill component pools in bulk
+    b.Entities.resize(b.Ids.size());
+    Reg_.create(b.Entities.begin(), b.Entities.end());
+    Reg_.insert<MassComponent>(b.Entities.begin(), b.Entities.end(), b.Masses.begin());
+    Reg_.insert<NameComponent>(b.Entities.begin(), b.Entities.end(), b.Names.begin());
+    Reg_.insert<RadiusComponent>(b.Entities.begin(), b.Entities.end(), b.Radii.begin());
+    Reg_.insert<StarDataComponent>(b.Entities.begin(), b.Entities.end(), b.StarData.begin());
+    Reg_.insert<SystemPositionComponent>(b.Entities.begin(), b.Entities.end(), b.Positions.begin());
+
+    for (auto i=0u; i<b.Ids.size(); ++i)
+    {
+        Id2EntityMap_.insert(b.Ids[i], b.Entities[i]);
+        this->notifyNewObject(b.Entities[i], b.Names[i].Name);
+    }
+}
+
+void IngestManager::cleanupScene()
+{
+    auto& Messages = Reg_.ctx<MessageHandler>();
+
+    for (auto l : ListenersCleanup_) l();
+
+    Id2EntityMap_.clear();
+    StaleObjects_ = StalePass();
+    StaleTires_ = StalePass();
+    IsGalaxyFromCache_ = false;
+    IsGalaxyStale_ = false;
+    GalaxyStarsReceived_ = 0;
+    ServerGalaxyHash_.clear();
+    auto v_1 = Reg_.view<NameComponent>();
+    auto v_2 = Reg_.view<TireComponent>();
+    Reg_.destroy(v_1.begin(), v_1.end());
+    Reg_.destroy(v_2.begin(), v_2.end());
+
+    DBLK(Messages.report("prg", "Registry size after disconnect (cleanup): " +
+                         std::to_string(Reg_.alive()) +
+                         " of " + std::to_string(Reg_.size()), MessageHandler::DEBUG_L1);)
+}
+
+void IngestManager::finishGalaxyTransfer()
+{
+    auto& Messages = Reg_.ctx<MessageHandler>();
+
+    IsNewHooks_ = true;
+    DBLK(Messages.report("prg", "Receiving systems successful", MessageHandler::DEBUG_L1);)
+    // Mesh is already built if the galaxy was taken from cache
+    if (!IsGalaxyFromCache_ || GalaxyStarsReceived_ > 0)
+    {
+        for (auto l : ListenersGalaxyReceived_) l();
+    }
+}
+
+void IngestManager::getObjectsFromQueue()
+{
+    Timers_.Queue.start();
+    auto& Parser = Reg_.ctx<ParserManager>();
+
+    Timers_.QueueOldestAge = 0.0;
+
+    // Drop documents applied last frame, keep the deferred ones
+    Pending_.erase(Pending_.begin(), Pending_.begin()+PendingFirst_);
+    PendingFirst_ = 0;
+
+    NetworkDocument Next;
+    while (Pending_.size() < PENDING_MAX && Parser.tryDequeue(Next))
+    {
+        Pending_.push_back(std::move(Next));
+    }
+
+    // Find the latest full update of each entity, deltas can't be skipped
+    // unless superseded by one
+    PendingLatest_.clear();
+    for (auto i=0u; i<Pending_.size(); ++i)
+    {
+        const auto& Doc = Pending_[i];
+        if (Doc.IsCoalescible && !Doc.IsDelta)
+        {
+            PendingLatest_[(std::uint64_t(Doc.Method) << 32) | Doc.Eid] = i;
+        }
+    }
+
+    // Documents arrive in order, hence the first one is the oldest
+    if (!Pending_.empty())
+    {
+        Timers_.QueueOldestAge = std::chrono::duration<double>(
+                                    std::chrono::steady_clock::now() - Pending_.front().Timestamp).count();
+    }
+
+    while (PendingFirst_ < Pending_.size())
+    {
+        auto& Doc = Pending_[PendingFirst_];
+        auto Latest = PendingLatest_.end();
+        if (Doc.IsCoalescible) Latest = PendingLatest_.find((std::uint64_t(Doc.Method) << 32) | Doc.Eid);
+        if (Latest != PendingLatest_.end() && Latest->second > PendingFirst_)
+        {
+            ++Timers_.QueueCoalesced;
+            Doc = NetworkDocument(); // Recycle document right away
+            ++PendingFirst_;
+            continue;
+        }
+        this->processDocument(Doc);
+        if (!Doc.Binary.empty()) PayloadPool::release(std::move(Doc.Binary));
+        Doc = NetworkDocument();
+        ++PendingFirst_;
+
+        // Leave the backlog for the next frame if out of time, at least
+        // one message is processed per frame
+        if (Timers_.Queue.split() > Timers_.QueueBudget) break;
+    }
+    // Server sent no further pass in time, the rest is gone, too
+    if ((StaleObjects_.IsPending || StaleTires_.IsPending) &&
+        ClockSync::getClientTime() > StaleDeadline_)
+    {
+        this->purgeStale<MotionComponent>(StaleObjects_);
+        this->purgeStale<TireComponent>(StaleTires_);
+    }
+
+    Timers_.QueueDeferred = Pending_.size() - PendingFirst_;
+    Timers_.QueueDepth = Parser.getQueueDepth() + Timers_.QueueDeferred;
+
+    Reg_.ctx<RequestTracker>().processTimeouts();
+
+    // Rebuilding the hook lists is expensive, do it once per frame at most
+    if (IsNewHooks_)
+    {
+        for (auto l : ListenersNewHooks_) l();
+        IsNewHooks_ = false;
+    }
+    Timers_.Queue.stop();
+    Timers_.QueueAvg.addValue(Timers_.Queue.elapsed());
+}
+
+void IngestManager::markStale()
+{
+    auto& Messages = Reg_.ctx<MessageHandler>();
+
+    auto v_1 = Reg_.view<NameComponent>();
+    auto v_2 = Reg_.view<TireComponent>();
+    // Objects might still be stale from a previous connection loss
+    for (auto e : v_1) Reg_.emplace_or_replace<StaleTag>(e);
+    for (auto e : v_2) Reg_.emplace_or_replace<StaleTag>(e);
+    IsGalaxyStale_ = !Reg_.view<StarDataComponent>().empty();
+
+    Messages.report("prg", "Connection lost, keeping " + std::to_string(Reg_.view<StaleTag>().size()) +
+                    " objects until reconnected", MessageHandler::INFO);
+}
+
+void IngestManager::resume()
+{
+    StaleObjects_.Updated.clear();
+    StaleObjects_.IsPending = true;
+    StaleTires_.Updated.clear();
+    StaleTires_.IsPending = true;
+    StaleDeadline_ = ClockSync::getClientTime() + STALE_TIMEOUT;
+}
+
+void IngestManager::notifyNewObject(entt::entity _e, const std::string& _Name)
+{
+    for (auto l : ListenersNewObject_) l(_e, _Name);
+}
+
+void IngestManager::notifyNewSystem(entt::entity _e, const std::string& _Name)
+{
+    for (auto l : ListenersNewSystem_) l(_e, _Name);
+}
+
+void IngestManager::processDocument(const NetworkDocument& _Doc)
+{
+    DocumentTime_ = std::chrono::duration<double>(_Doc.Timestamp.time_since_epoch()).count();
+
+    if (!_Doc.Binary.empty())
+    {
+        this->applyBinary(_Doc.Binary);
+        return;
+    }
+    // Parse errors are already reported by parser workers
+    if (!_Doc.Payload) return;
+
+    const auto& j = _Doc.Payload->Document;
+
+    if (j.IsObject())
+    {
+        this->processValue(j, _Doc.Method);
+    }
+    else if (j.IsArray())
+    {
+        // JSON-RPC batch, typically the responses to a batch of requests.
+        // Method ids are only computed by parser workers for single messages
+        for (const auto& Element : j.GetArray())
+        {
+            if (!Element.IsObject()) continue;
+            entt::id_type Method{0};
+            auto it = Element.FindMember("method");
+            if (it != Element.MemberEnd() && it->value.IsString())
+                Method = MethodDispatcher::hash(it->value.GetString(), it->value.GetStringLength());
+            this->processValue(Element, Method);
+        }
+    }
+}
+
+void IngestManager::processValue(const rapidjson::Value& _j, entt::id_type _Method)
+{
+    auto& Dispatcher = Reg_.ctx<MethodDispatcher>();
+    auto& Messages = Reg_.ctx<MessageHandler>();
+
+    if (_Method != 0)
+    {
+        auto it = _j.FindMember("params");
+        if (it != _j.MemberEnd())
+        {
+            if (!Dispatcher.dispatch(_Method, it->value))
+            {
+                DBLK(Messages.report("prg", "Unknown method " + std::string(_j["method"].GetString()), MessageHandler::DEBUG_L2);)
+            }
+        }
+    }
+    // Responses, matched to their request by id
+    auto Result = _j.FindMember("result");
+    auto Error = _j.FindMember("error");
+    if (Result == _j.MemberEnd() && Error == _j.MemberEnd()) return;
+
+    auto Id = _j.FindMember("id");
+    if (Id != _j.MemberEnd() && Id->value.IsUint())
+    {
+        auto& Tracker = Reg_.ctx<RequestTracker>();
+        if (Result != _j.MemberEnd())
+            Tracker.complete(Id->value.GetUint(), RequestTracker::StatusE::SUCCESS, Result->value);
+        else
+            Tracker.complete(Id->value.GetUint(), RequestTracker::StatusE::ERROR, Error->value);
+    }
+    else if (Result != _j.MemberEnd() && Result->value == "success")
+    {
+        // Servers not returning the request id only answer the galaxy
+        // subscription
+        this->finishGalaxyTransfer();
+    }
+    else if (Error != _j.MemberEnd())
+    {
+        Messages.report("prg", "Server returned error without request id", MessageHandler::WARNING);
+    }
+}
+
+template<class Component>
+void IngestManager::purgeStale(StalePass& _Pass)
+{
+    auto& Messages = Reg_.ctx<MessageHandler>();
+
+    if (!_Pass.IsPending) return;
+    _Pass.IsPending = false;
+    _Pass.Updated.clear();
+
+    std::vector<entt::entity> Gone;
+    auto v = Reg_.view<StaleTag, Component>();
+    Gone.insert(Gone.end(), v.begin(), v.end());
+    if (Gone.empty()) return;
+
+    for (auto e : Gone)
+    {
+        for (auto l : ListenersRemovedObject_) l(e);
+    }
+    Reg_.destroy(Gone.begin(), Gone.end());
+    Id2EntityMap_.eraseIf([this](std::uint32_t, entt::entity _e){return !Reg_.valid(_e);});
+    // Hooks of destroyed objects are removed
+    IsNewHooks_ = true;
+
+    Messages.report("prg", "Removed " + std::to_string(Gone.size()) +
+                    " stale objects gone while disconnected", MessageHandler::INFO);
+}
+
+void IngestManager::requestKeyframe(std::uint32_t _Id)
+{
+    auto& Json = Reg_.ctx<JsonManager>();
+    auto& Messages = Reg_.ctx<MessageHandler>();
+
+    const auto Id = Json.createRequest("cmd_request_keyframe")
+        .addParam("eid", _Id)
+        .finalise();
+    OutputQueue_->enqueue(Json.getString());
+    Reg_.ctx<RequestTracker>().track(Id, "cmd_request_keyframe");
+    ++Timers_.QueueKeyframeRequests;
+    DBLK(Messages.report("prg", "Requesting keyframe for object " + std::to_string(_Id), MessageHandler::DEBUG_L2);)
+}
+
+void IngestManager::setupHandlers()
+{
+    auto& Dispatcher = Reg_.ctx<MethodDispatcher>();
+
+    Dispatcher.registerMethod("galaxy_data_stars", [this](const rapidjson::Value& _p)
+    {
+        this->applyStar(_p["eid"].GetUint(),
+                        _p["name"].GetString(), _p["name"].GetStringLength(),
+                        _p["m"].GetDouble(),
+                        _p["r"].GetDouble(),
+                        _p["spx"].GetDouble(),
+                        _p["spy"].GetDouble(),
+                        SpectralClassE(_p["sc"].GetInt()),
+                        _p["t"].GetDouble());
+    });
+
+    // Column arrays of stars, negotiated by sub_galaxy_data_evt. The single
+    // star message above remains as fallback
+    Dispatcher.registerMethod("galaxy_data_stars_batch", [this](const rapidjson::Value& _p)
+    {
+        this->applyGalaxyStarsBatch(_p);
+    });
+
+    Dispatcher.registerMethod("galaxy_data_systems", [this](const rapidjson::Value& _p)
+    {
+        this->applySystem(_p["eid"].GetUint(),
+                          _p["name"].GetString(), _p["name"].GetStringLength());
+    });
+
+    // Sent before the galaxy is streamed. If the cache holds the same galaxy,
+    // the server only streams what differs
+    Dispatcher.registerMethod("galaxy_info", [this](const rapidjson::Value& _p)
+    {
+        auto& Cache = Reg_.ctx<GalaxyCache>();
+        auto& Messages = Reg_.ctx<MessageHandler>();
+
+        const std::string Hash = _p["hash"].GetString();
+        if (IsGalaxyStale_)
+        {
+            IsGalaxyStale_ = false;
+            if (Hash == ServerGalaxyHash_)
+            {
+                // Resumed after reconnecting, nothing to reload
+                std::vector<entt::entity> Stale;
+                auto v_1 = Reg_.view<StaleTag, StarDataComponent>();
+                auto v_2 = Reg_.view<StaleTag, StarSystemTag>();
+                Stale.insert(Stale.end(), v_1.begin(), v_1.end());
+                Stale.insert(Stale.end(), v_2.begin(), v_2.end());
+                Reg_.remove<StaleTag>(Stale.begin(), Stale.end());
+                Messages.report("prg", "Galaxy unchanged, keeping it", MessageHandler::INFO);
+                return;
+            }
+            Messages.report("prg", "Galaxy changed while disconnected, reloading", MessageHandler::INFO);
+            this->cleanupScene();
+        }
+        ServerGalaxyHash_ = Hash;
+        // Galaxy might be present already if subscribed again
+        if (Cache.isLoaded() && Cache.getHash() == ServerGalaxyHash_ &&
+            !IsGalaxyFromCache_ && GalaxyStarsReceived_ == 0 &&
+            Reg_.view<StarDataComponent>().empty())
+        {
+            Messages.report("prg", "Galaxy cache is up to date, loading", MessageHandler::INFO);
+            this->applyGalaxyCache();
+        }
+    });
+
+    // Full updates (older servers), keyframes or deltas of changed fields
+    Dispatcher.registerMethod("bc_dynamic_data", [this](const rapidjson::Value& _p)
+    {
+        DynamicUpdate u;
+        u.Eid = _p["eid"].GetUint();
+
+        auto it = _p.FindMember("seq");
+        if (it != _p.MemberEnd())
+        {
+            u.Seq = it->value.GetUint();
+            u.HasSeq = true;
+            it = _p.FindMember("kf");
+            if (it != _p.MemberEnd() && it->value.GetBool()) u.Fields |= DynamicUpdate::FIELD_KEYFRAME;
+        }
+        it = _p.FindMember("name");
+        if (it != _p.MemberEnd())
+        {
+            u.Name = it->value.GetString();
+            u.NameLength = it->value.GetStringLength();
+            u.Fields |= DynamicUpdate::FIELD_NAME;
+        }
+        it = _p.FindMember("m");
+        if (it != _p.MemberEnd())
+        {
+            u.m = it->value.GetDouble();
+            u.Fields |= DynamicUpdate::FIELD_MASS;
+        }
+        it = _p.FindMember("r");
+        if (it != _p.MemberEnd())
+        {
+            u.r = it->value.GetDouble();
+            u.Fields |= DynamicUpdate::FIELD_RADIUS;
+        }
+        it = _p.FindMember("spx");
+        if (it != _p.MemberEnd())
+        {
+            u.spx = it->value.GetDouble();
+            u.spy = _p["spy"].GetDouble();
+            u.Fields |= DynamicUpdate::FIELD_SYSTEM_POSITION;
+        }
+        it = _p.FindMember("px");
+        if (it != _p.MemberEnd())
+        {
+            u.px = it->value.GetDouble();
+            u.py = _p["py"].GetDouble();
+            u.Fields |= DynamicUpdate::FIELD_POSITION;
+        }
+        it = _p.FindMember("t");
+        if (it != _p.MemberEnd())
+        {
+            u.t = it->value.GetDouble();
+            u.HasTime = true;
+            Reg_.ctx<ClockSync>().addUpdate(u.t);
+        }
+        this->applyDynamicUpdate(u);
+    });
+
+    Dispatcher.registerMethod("perf_stats", [this](const rapidjson::Value& _p)
+    {
+        Timers_.ServerPhysicsFrameTimeAvg.addValue(_p["t_phy"].GetDouble());
+        Timers_.ServerQueueInFrameTimeAvg.addValue(_p["t_queue_in"].GetDouble());
+        Timers_.ServerQueueOutFrameTimeAvg.addValue(_p["t_queue_out"].GetDouble());
+        Timers_.ServerSimFrameTimeAvg.addValue(_p["t_sim"].GetDouble());
+    });
+
+    Dispatcher.registerMethod("sim_stats", [this](const rapidjson::Value& _p)
+    {
+        SimTime_.fromStamp(_p["ts"].GetString());
+        SimTime_.setAcceleration(_p["ts_f"].GetDouble());
+    });
+
+    Dispatcher.registerMethod("tire_data", [this](const rapidjson::Value& _p)
+    {
+        std::array<double, 2*TireComponent::SEGMENTS> Rubber;
+        for (auto i=0u; i<Rubber.size(); ++i)
+        {
+            Rubber[i] = _p["rubber"][i].GetDouble();
+        }
+        this->applyTire(_p["eid"].GetUint(),
+                        _p["rim_xy"][0].GetDouble(),
+                        _p["rim_xy"][1].GetDouble(),
+                        _p["rim_r"].GetDouble(),
+                        Rubber.data());
+        auto it = _p.FindMember("t");
+        if (it != _p.MemberEnd()) Reg_.ctx<ClockSync>().addUpdate(it->value.GetDouble());
+    });
+}
+
+void IngestManager::writeGalaxyCache(const std::vector<float>& _Vertices)
+{
+    auto& Cache = Reg_.ctx<GalaxyCache>();
+    auto& Messages = Reg_.ctx<MessageHandler>();
+
+    if (GalaxyStarsReceived_ == 0 || ServerGalaxyHash_.empty()) return;
+
+    if (Cache.write(ServerGalaxyHash_, Reg_, Id2EntityMap_, _Vertices))
+    {
+        Messages.report("prg", "Galaxy cache written (" + std::to_string(Cache.getStarCount()) + " stars)",
+                        MessageHandler::INFO);
+    }
+    else
+    {
+        Messages.report("prg", "Couldn't write galaxy cache", MessageHandler::WARNING);
+    }
+    GalaxyStarsReceived_ = 0;
+}
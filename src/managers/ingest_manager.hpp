@@ -0,0 +1,195 @@
+#ifndef INGEST_MANAGER_HPP
+#define INGEST_MANAGER_HPP
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <entt/entity/registry.hpp>
+#include <rapidjson/document.h>
+
+#include "components.hpp"
+#include "dynamic_update.hpp"
+#include "flat_id_map.hpp"
+#include "network_message.hpp"
+#include "parser_manager.hpp"
+#include "performance_timers.hpp"
+#include "sim_timer.hpp"
+
+// Applies parsed server messages to the registry. Independent of window,
+// GL context and UI, which are informed by listeners, so that the ingest
+// path is shared by the desktop and the headless client
+class IngestManager
+{
+
+    public:
+
+        // Positions of an object closer in time than this replace the
+        // latest one instead of being interpolated in between
+        static constexpr double MOTION_INTERVAL_MIN = 0.002;
+        // Stale objects are destroyed after reconnecting at the latest
+        // after this many seconds, if the server sends no more updates
+        static constexpr double STALE_TIMEOUT = 5.0;
+
+        explicit IngestManager(entt::registry& _Reg, PerformanceTimers& _Timers, SimTimer& _SimTime) :
+                Reg_(_Reg),
+                Timers_(_Timers),
+                SimTime_(_SimTime) {}
+
+        void init(OutgoingQueue* const _OutputQueue);
+
+        // Apply documents of the parser within the frame's time budget, to
+        // be called from the render (main) thread once per frame
+        void getObjectsFromQueue();
+        void cleanupScene();
+        // Galaxy subscription was answered, i.e. all stars and systems were sent
+        void finishGalaxyTransfer();
+        // Keep the scene of a lost connection, objects are tagged stale
+        // until the server updates them after reconnecting
+        void markStale();
+        // Reconnected, stale dynamic objects and tires that are not updated
+        // within the first pass of updates are gone and destroyed
+        void resume();
+
+        // Writes the received galaxy to the cache, if it was streamed by
+        // the server. Vertices as given by RenderSystem::getGalaxyVertices
+        void writeGalaxyCache(const std::vector<float>& _Vertices);
+
+        std::size_t getObjectCount() const {return Id2EntityMap_.size();}
+        std::size_t getStaleCount() const {return Reg_.view<StaleTag>().size();}
+        // Positions of dynamic objects applied so far, changes once per
+        // frame with new positions
+        std::uint64_t getPositionUpdates() const {return PositionUpdates_;}
+        // Client time the document being applied was received at, see
+        // ClockSync::getClientTime()
+        double getDocumentTime() const {return DocumentTime_;}
+
+        // New star, dynamic object or tire, i.e. a possible camera hook
+        void addListenerNewObject(std::function<void(entt::entity, const std::string&)> _f)
+        {
+            ListenersNewObject_.push_back(_f);
+        }
+        void addListenerNewSystem(std::function<void(entt::entity, const std::string&)> _f)
+        {
+            ListenersNewSystem_.push_back(_f);
+        }
+        // Called at most once per frame after new objects or systems were added
+        void addListenerNewHooks(std::function<void(void)> _f)
+        {
+            ListenersNewHooks_.push_back(_f);
+        }
+        // Dynamic object or tire destroyed on its own, e.g. since it was
+        // gone when reconnecting
+        void addListenerRemovedObject(std::function<void(entt::entity)> _f)
+        {
+            ListenersRemovedObject_.push_back(_f);
+        }
+        // Galaxy transfer finished, the galaxy has to be (re)built from the registry
+        void addListenerGalaxyReceived(std::function<void(void)> _f)
+        {
+            ListenersGalaxyReceived_.push_back(_f);
+        }
+        // Scene is about to be destroyed, e.g. after disconnecting or since
+        // the galaxy changed while reconnecting
+        void addListenerCleanup(std::function<void(void)> _f)
+        {
+            ListenersCleanup_.push_back(_f);
+        }
+        // Galaxy was taken from the cache, including its vertices
+        void addListenerGalaxyCached(std::function<void(const float*, std::size_t)> _f)
+        {
+            ListenersGalaxyCached_.push_back(_f);
+        }
+
+    private:
+
+        // Objects updated since reconnecting. Once an object is updated
+        // twice, the server started its next pass, stale objects of the
+        // same kind not updated so far are gone
+        struct StalePass
+        {
+            std::unordered_set<std::uint32_t> Updated;
+            bool IsPending{false};
+        };
+
+        void addMotion(entt::entity _e, const DynamicUpdate& _u, bool _IsReset);
+        void applyBinary(const std::string& _Data);
+        void applyDynamicUpdate(const DynamicUpdate& _u);
+        void applyGalaxyCache();
+        void applyGalaxyStarsBatch(const rapidjson::Value& _p);
+        void applyStar(entt::id_type _Id, const char* _Name, std::size_t _NameLength,
+                       double _m, double _r, double _spx, double _spy, SpectralClassE _SC, double _t);
+        void applySystem(entt::id_type _Id, const char* _Name, std::size_t _NameLength);
+        void applyTire(entt::id_type _Id, double _RimX, double _RimY, double _RimR, const double* _Rubber);
+        void notifyNewObject(entt::entity _e, const std::string& _Name);
+        void notifyNewSystem(entt::entity _e, const std::string& _Name);
+        void processDocument(const NetworkDocument& _Doc);
+        void processValue(const rapidjson::Value& _j, entt::id_type _Method);
+        template<class Component>
+        void purgeStale(StalePass& _Pass);
+        void requestKeyframe(std::uint32_t _Id);
+        void setupHandlers();
+
+        entt::registry& Reg_;
+        PerformanceTimers& Timers_;
+        SimTimer& SimTime_;
+
+        OutgoingQueue* OutputQueue_{nullptr};
+
+        bool IsNewHooks_{false};
+        // Client time the document being processed was received at, see
+        // ClockSync::getClientTime()
+        double DocumentTime_{0.0};
+        std::uint64_t PositionUpdates_{0};
+
+        // Galaxy announced by the server, see GalaxyCache
+        std::string ServerGalaxyHash_;
+        bool IsGalaxyFromCache_{false};
+        // Galaxy of a lost connection is kept, if the server announces the same
+        bool IsGalaxyStale_{false};
+        std::size_t GalaxyStarsReceived_{0};
+
+        // Objects updated since reconnecting, see StalePass
+        StalePass StaleObjects_;
+        StalePass StaleTires_;
+        double StaleDeadline_{0.0};
+
+        // Documents dequeued from the parser but not yet applied. Updates
+        // in here are coalesced, only the latest per entity is applied.
+        // Parsed documents hold one of the parser's DOCUMENTS_MAX buffers,
+        // at most half of them are held here, so that workers can still
+        // parse ahead while the backlog is applied
+        static constexpr std::size_t PENDING_MAX = ParserManager::DOCUMENTS_MAX / 2;
+        std::vector<NetworkDocument> Pending_;
+        std::size_t PendingFirst_{0};
+        std::unordered_map<std::uint64_t, std::size_t> PendingLatest_;
+
+        FlatIdMap Id2EntityMap_;
+
+        // Columns of new stars for bulk insertion, kept to reuse capacity
+        struct
+        {
+            std::vector<entt::entity> Entities;
+            std::vector<std::uint32_t> Ids;
+            // Column index of new stars by id
+            std::unordered_map<std::uint32_t, std::size_t> Index;
+            std::vector<MassComponent> Masses;
+            std::vector<NameComponent> Names;
+            std::vector<SystemPositionComponent> Positions;
+            std::vector<RadiusComponent> Radii;
+            std::vector<StarDataComponent> StarData;
+        } StarBatch_;
+
+        std::vector<std::function<void(entt::entity, const std::string&)>> ListenersNewObject_;
+        std::vector<std::function<void(entt::entity, const std::string&)>> ListenersNewSystem_;
+        std::vector<std::function<void(void)>> ListenersCleanup_;
+        std::vector<std::function<void(entt::entity)>> ListenersRemovedObject_;
+        std::vector<std::function<void(void)>> ListenersNewHooks_;
+        std::vector<std::function<void(void)>> ListenersGalaxyReceived_;
+        std::vector<std::function<void(const float*, std::size_t)>> ListenersGalaxyCached_;
+};
+
+#endif // INGEST_MANAGER_HPP
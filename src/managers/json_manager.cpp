@@ -71,6 +71,36 @@ JsonManager& JsonManager::addParam(const char* _Name, const char* _v)
     return *this;
 }
 
+JsonManager& JsonManager::addNamedValue(const char* _n, bool _v)
+{
+    DBLK(this->checkCreate();)
+
+    Writer_.Key(_n);
+    Writer_.Bool(_v);
+
+    return *this;
+}
+
+JsonManager& JsonManager::addNamedValue(const char* _n, double _v)
+{
+    DBLK(this->checkCreate();)
+
+    Writer_.Key(_n);
+    Writer_.Double(_v);
+
+    return *this;
+}
+
+JsonManager& JsonManager::addNamedValue(const char* _n, const char* _v)
+{
+    DBLK(this->checkCreate();)
+
+    Writer_.Key(_n);
+    Writer_.String(_v);
+
+    return *this;
+}
+
 JsonManager& JsonManager::addValue(double _v)
 {
     DBLK(this->checkCreate();)
@@ -211,7 +241,7 @@ JsonManager& JsonManager::createResult(const std::string& _r)
     return *this;
 }
 
-void JsonManager::finalise(RequestIDType _ReqID)
+JsonManager::RequestIDType JsonManager::finalise(RequestIDType _ReqID)
 {
     DBLK(this->checkCreate();
         IsMessageCreated_ = false;
@@ -224,6 +254,7 @@ void JsonManager::finalise(RequestIDType _ReqID)
         {
             Writer_.Key("id");
             Writer_.Uint(++RequestID_);
+            _ReqID = RequestID_;
         }
     }
     else // if (MessageType_ == MessageType::RESULT || MessageType_ == MessageType::ERROR)
@@ -236,6 +267,7 @@ void JsonManager::finalise(RequestIDType _ReqID)
     }
     Writer_.EndObject();
     HasParams_ = false;
+    return _ReqID;
 }
 
 JsonManager::ParamCheckResult JsonManager::checkParams(std::shared_ptr<const rapidjson::Document> _d, std::vector<ParamsType> _p)
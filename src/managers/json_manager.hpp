@@ -86,6 +86,7 @@ class JsonManager
 
         // Add a key-value pair
         JsonManager& addNamedValue(const char* _n, bool _v);
+        JsonManager& addNamedValue(const char* _n, double _v);
         JsonManager& addNamedValue(const char* _n, const char* _v);
 
         // Add a singular value, mainly in arrays
@@ -94,7 +95,9 @@ class JsonManager
         JsonManager& addValue(int _v);
         JsonManager& addValue(const char* _v);
 
-        void finalise(RequestIDType _ReqID = 0);
+        // Returns the id of a request, to be tracked by the sender (see
+        // RequestTracker), or the given id of a result or error
+        RequestIDType finalise(RequestIDType _ReqID = 0);
         RequestIDType getRequestID() const {return RequestID_;}
         const char* getString() const {return Buffer_.GetString();}
 
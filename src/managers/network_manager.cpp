@@ -1,11 +1,14 @@
 #include "network_manager.hpp"
 
+#include <algorithm>
+#include <cmath>
+
 #include "message_handler.hpp"
 
 #include "timer.hpp"
 
-bool NetworkManager::init(moodycamel::ConcurrentQueue<std::string>* const _InputQueue,
-                          moodycamel::ConcurrentQueue<std::string>* const _OutputQueue)
+bool NetworkManager::init(moodycamel::BlockingConcurrentQueue<NetworkMessage>* const _InputQueue,
+                          OutgoingQueue* const _OutputQueue)
 {
     InputQueue_ = _InputQueue;
     OutputQueue_ = _OutputQueue;
@@ -14,8 +17,6 @@ bool NetworkManager::init(moodycamel::ConcurrentQueue<std::string>* const _Input
     Client_.clear_access_channels(websocketpp::log::alevel::frame_header);
     Client_.clear_access_channels(websocketpp::log::alevel::frame_payload);
     Client_.set_error_channels(websocketpp::log::elevel::all);
-    Client_.get_elog().set_ostream(&ErrorStream_);
-    Client_.get_alog().set_ostream(&MessageStream_);
     Client_.set_close_handler(std::bind(&NetworkManager::onClose, this,
                               std::placeholders::_1));
     Client_.set_fail_handler(std::bind(&NetworkManager::onFail, this));
@@ -46,30 +47,74 @@ bool NetworkManager::connect(const std::string& _Uri)
     {
         auto& Messages = Reg_.ctx<MessageHandler>();
 
-        if (ThreadClient_.joinable())
-        {
-            this->reset();
-            DBLK(Messages.report("net", "Closing stale connection", MessageHandler::DEBUG_L1);)
-        }
-
-        DBLK(Messages.report("net", "Connecting", MessageHandler::DEBUG_L1);)
-
-        websocketpp::lib::error_code ErrorCode;
-        ClientType::connection_ptr Con = Client_.get_connection(_Uri, ErrorCode);
-        if (ErrorCode)
+        if (IsReplaying_)
         {
-            Messages.report("net", "Couldn't start client: " + ErrorCode.message(), MessageHandler::ERROR);
+            Messages.report("net", "Replaying session, stop replay before connecting", MessageHandler::WARNING);
             return false;
         }
-        Client_.connect(Con);
 
-        ThreadClient_ = std::thread(std::bind(&ClientType::run, &Client_));
+        // A new session, nothing to resume
+        IsDisconnectRequested_.store(false);
+        IsReconnecting_.store(false);
+        IsReconnectDue_.store(false);
+        IsReconnectScheduled_ = false;
+        ReconnectAttempts_.store(0);
+        Uri_ = _Uri;
+
+        return this->open(_Uri);
     }
     return true;
 }
 
+void NetworkManager::processReconnect()
+{
+    if (!IsReconnecting_) return;
+
+    auto& Messages = Reg_.ctx<MessageHandler>();
+    const auto Now = std::chrono::steady_clock::now();
+
+    if (IsReconnectDue_.exchange(false))
+    {
+        // Exponential backoff with jitter, so that the clients of a
+        // restarted server don't reconnect all at once
+        double Delay = std::min(RECONNECT_DELAY_MIN * std::pow(2.0, ReconnectAttempts_.load()),
+                                RECONNECT_DELAY_MAX);
+        Delay *= std::uniform_real_distribution<double>(0.8, 1.2)(ReconnectJitter_);
+        ReconnectTime_ = Now + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                   std::chrono::duration<double>(Delay));
+        IsReconnectScheduled_ = true;
+        Messages.report("net", "Reconnecting in " + std::to_string(Delay) + " s (attempt " +
+                        std::to_string(ReconnectAttempts_.load()+1) + ")", MessageHandler::INFO);
+    }
+    if (IsReconnectScheduled_ && Now >= ReconnectTime_)
+    {
+        IsReconnectScheduled_ = false;
+        ReconnectAttempts_.fetch_add(1);
+        if (!this->open(Uri_)) IsReconnectDue_.store(true);
+    }
+}
+
+void NetworkManager::cancelReconnect()
+{
+    if (!IsReconnecting_.exchange(false)) return;
+
+    IsReconnectDue_.store(false);
+    IsReconnectScheduled_ = false;
+
+    // Abort an attempt in progress
+    Client_.stop();
+    if (ThreadClient_.joinable()) this->reset();
+    IsConnected_.store(false);
+
+    Reg_.ctx<MessageHandler>().report("net", "Reconnecting stopped", MessageHandler::INFO);
+    for (auto l : ListenersDisconnect) l();
+}
+
 bool NetworkManager::disconnect()
 {
+    IsDisconnectRequested_.store(true);
+    this->cancelReconnect();
+
     if (IsConnected_)
     {
         auto& Messages = Reg_.ctx<MessageHandler>();
@@ -93,34 +138,182 @@ bool NetworkManager::disconnect()
 
 void NetworkManager::quit()
 {
+    this->stopReplay();
+    this->stopRecording();
     this->disconnect();
     if (ThreadClient_.joinable()) this->reset();
     IsRunning_.store(false);
+    OutputQueue_->wake();
     ThreadSender_.join();
 }
 
-void NetworkManager::onClose(websocketpp::connection_hdl _Connection)
+bool NetworkManager::startRecording(const std::string& _File)
 {
     auto& Messages = Reg_.ctx<MessageHandler>();
-    Messages.report("net", "Connection closed", MessageHandler::INFO);
 
-    for (auto l : ListenersDisconnect) l();
+    std::lock_guard<std::mutex> Lock(RecordMutex_);
+    if (Record_.isOpen()) Record_.close();
+    if (!Record_.open(_File))
+    {
+        Messages.report("net", "Couldn't open session log " + _File + " for recording", MessageHandler::ERROR);
+        return false;
+    }
+    RecordStart_ = std::chrono::steady_clock::now();
+    IsRecording_.store(true);
+    Messages.report("net", "Recording session to " + _File, MessageHandler::INFO);
+    return true;
+}
+
+void NetworkManager::stopRecording()
+{
+    std::lock_guard<std::mutex> Lock(RecordMutex_);
+    if (IsRecording_)
+    {
+        IsRecording_.store(false);
+        Record_.close();
+        Reg_.ctx<MessageHandler>().report("net", "Recording stopped", MessageHandler::INFO);
+    }
+}
+
+bool NetworkManager::startReplay(const std::string& _File, double _Speed)
+{
+    auto& Messages = Reg_.ctx<MessageHandler>();
+
+    if (IsConnected_ || IsReconnecting_)
+    {
+        Messages.report("net", "Connected to server, disconnect before replaying", MessageHandler::WARNING);
+        return false;
+    }
+    this->stopReplay();
+
+    IsReplaying_.store(true);
+    ThreadReplay_ = std::thread(&NetworkManager::replay, this, _File, _Speed);
+    return true;
+}
+
+void NetworkManager::processLog()
+{
+    auto& Messages = Reg_.ctx<MessageHandler>();
+    auto& Ring = getWebsocketLogRing();
+
+    Ring.drain([&Messages](const LogRing::Record& _r)
+    {
+        if (_r.IsError)
+        {
+            Messages.report("net", "WebSocket++: " + std::string(_r.Text, _r.Length));
+        }
+        else
+        {
+            DBLK(Messages.report("net", "WebSocket++: " + std::string(_r.Text, _r.Length), MessageHandler::DEBUG_L1);)
+        }
+    });
+
+    const auto Dropped = Ring.getDropped();
+    if (Dropped > LogDropped_)
+    {
+        Messages.report("net", "WebSocket++: " + std::to_string(Dropped - LogDropped_) +
+                        " log messages dropped", MessageHandler::WARNING);
+        LogDropped_ = Dropped;
+    }
+}
+
+void NetworkManager::stopReplay()
+{
+    IsReplaying_.store(false);
+    if (ThreadReplay_.joinable()) ThreadReplay_.join();
+}
+
+std::uint64_t NetworkManager::getBytesWire() const
+{
+    #ifdef PWNG_WEBSOCKET_COMPRESSION
+        const auto& Deflate = ClientConfig::permessage_deflate_type::getStats();
+        return Stats_.BytesRaw.load() - Deflate.BytesDecompressed.load() + Deflate.BytesCompressed.load();
+    #else
+        return Stats_.BytesRaw.load();
+    #endif
+}
+
+double NetworkManager::getDecompressTime() const
+{
+    #ifdef PWNG_WEBSOCKET_COMPRESSION
+        return ClientConfig::permessage_deflate_type::getStats().DecompressTime.load();
+    #else
+        return 0.0;
+    #endif
+}
+
+void NetworkManager::onClose(websocketpp::connection_hdl _Connection)
+{
+    auto& Messages = Reg_.ctx<MessageHandler>();
 
     IsConnected_.store(false);
+    // Pending timer would keep the client thread running
+    if (RatesTimer_) RatesTimer_->cancel();
+    RatesTimer_.reset();
+    this->clearRates();
+    if (IsDisconnectRequested_ || !IsReconnectEnabled_ || Uri_.empty())
+    {
+        Messages.report("net", "Connection closed", MessageHandler::INFO);
+        for (auto l : ListenersDisconnect) l();
+    }
+    else
+    {
+        Messages.report("net", "Connection lost", MessageHandler::WARNING);
+        IsReconnecting_.store(true);
+        IsReconnectDue_.store(true);
+        for (auto l : ListenersConnectionLost_) l();
+    }
+    OutputQueue_->wake();
 }
 
 void NetworkManager::onFail()
 {
     auto& Messages = Reg_.ctx<MessageHandler>();
-    Messages.report("net", "Connection failed", MessageHandler::ERROR);
     IsConnected_.store(false);
+    if (IsReconnecting_)
+    {
+        Messages.report("net", "Reconnect failed", MessageHandler::WARNING);
+        IsReconnectDue_.store(true);
+    }
+    else
+    {
+        Messages.report("net", "Connection failed", MessageHandler::ERROR);
+    }
+    OutputQueue_->wake();
 }
 
 void NetworkManager::onMessage(websocketpp::connection_hdl _Connection, ClientType::message_ptr _Msg)
 {
     auto& Messages = Reg_.ctx<MessageHandler>();
-    DBLK(Messages.report("net", "Enqueueing incoming message\n" + _Msg->get_payload(), MessageHandler::DEBUG_L3);)
-    InputQueue_->enqueue(_Msg->get_payload());
+    DBLK(Messages.report("net", "Enqueueing incoming message (" + std::to_string(_Msg->get_payload().size()) + " bytes)", MessageHandler::DEBUG_L3);)
+    Stats_.BytesRaw.fetch_add(_Msg->get_payload().size(), std::memory_order_relaxed);
+    Stats_.MessagesIn.fetch_add(1, std::memory_order_relaxed);
+    // Single writer, no compare-exchange needed
+    if (_Msg->get_payload().size() > Stats_.MessageSizeInMax.load(std::memory_order_relaxed))
+        Stats_.MessageSizeInMax.store(_Msg->get_payload().size(), std::memory_order_relaxed);
+
+    const bool IsBinary = (_Msg->get_opcode() == websocketpp::frame::opcode::binary);
+    if (IsRecording_)
+    {
+        std::lock_guard<std::mutex> Lock(RecordMutex_);
+        if (IsRecording_ &&
+            !Record_.write(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                               std::chrono::steady_clock::now() - RecordStart_).count(),
+                           IsBinary, _Msg->get_payload()))
+        {
+            Messages.report("net", "Writing session log failed, recording stopped", MessageHandler::ERROR);
+            IsRecording_.store(false);
+            Record_.close();
+        }
+    }
+
+    // Take over websocketpp's (pooled) buffer instead of copying it
+    NetworkMessage Message;
+    Message.Payload.swap(_Msg->get_raw_payload());
+    Message.Sequence = InputSequence_++;
+    Message.IsBinary = IsBinary;
+    Message.Timestamp = std::chrono::steady_clock::now();
+    InputQueue_->enqueue(std::move(Message));
 }
 
 bool NetworkManager::onOpen(websocketpp::connection_hdl _Connection)
@@ -128,12 +321,121 @@ bool NetworkManager::onOpen(websocketpp::connection_hdl _Connection)
     auto& Messages = Reg_.ctx<MessageHandler>();
 
     Messages.report("net", "Connection opened", MessageHandler::INFO);
+    #ifdef PWNG_WEBSOCKET_COMPRESSION
+        auto Con = Client_.get_con_from_hdl(_Connection);
+        const auto& Extensions = Con->get_response_header("Sec-WebSocket-Extensions");
+        if (Extensions.find("permessage-deflate") != std::string::npos)
+        {
+            Messages.report("net", "Compression (permessage-deflate) enabled", MessageHandler::INFO);
+        }
+        else
+        {
+            Messages.report("net", "Compression (permessage-deflate) declined by server", MessageHandler::INFO);
+        }
+    #endif
     Connection_ = _Connection;
     IsConnected_.store(true);
+    ReconnectAttempts_.store(0);
+    RatesTime_ = std::chrono::steady_clock::now();
+    RatesBytesIn_ = Stats_.BytesRaw.load(std::memory_order_relaxed);
+    RatesBytesOut_ = Stats_.BytesOut.load(std::memory_order_relaxed);
+    RatesMessagesIn_ = Stats_.MessagesIn.load(std::memory_order_relaxed);
+    RatesMessagesOut_ = Stats_.MessagesOut.load(std::memory_order_relaxed);
+    this->scheduleRates();
+    if (IsReconnecting_.exchange(false))
+    {
+        Messages.report("net", "Reconnected", MessageHandler::INFO);
+        for (auto l : ListenersReconnect_) l();
+    }
+    // Send what was enqueued before the connection was established
+    OutputQueue_->wake();
 
     return true;
 }
 
+bool NetworkManager::open(const std::string& _Uri)
+{
+    auto& Messages = Reg_.ctx<MessageHandler>();
+
+    if (ThreadClient_.joinable())
+    {
+        this->reset();
+        DBLK(Messages.report("net", "Closing stale connection", MessageHandler::DEBUG_L1);)
+    }
+
+    DBLK(Messages.report("net", "Connecting", MessageHandler::DEBUG_L1);)
+
+    websocketpp::lib::error_code ErrorCode;
+    ClientType::connection_ptr Con = Client_.get_connection(_Uri, ErrorCode);
+    if (ErrorCode)
+    {
+        Messages.report("net", "Couldn't start client: " + ErrorCode.message(), MessageHandler::ERROR);
+        return false;
+    }
+    Client_.connect(Con);
+
+    ThreadClient_ = std::thread(std::bind(&ClientType::run, &Client_));
+    return true;
+}
+
+void NetworkManager::replay(std::string _File, double _Speed)
+{
+    auto& Messages = Reg_.ctx<MessageHandler>();
+
+    SessionLogReader Log;
+    if (!Log.open(_File))
+    {
+        Messages.report("net", "Couldn't open session log " + _File + " for replay", MessageHandler::ERROR);
+        IsReplaying_.store(false);
+        return;
+    }
+    Messages.report("net", "Replaying session " + _File + " at speed " + std::to_string(_Speed),
+                    MessageHandler::INFO);
+
+    const auto Start = std::chrono::steady_clock::now();
+    RatesTime_ = Start;
+    RatesBytesIn_ = Stats_.BytesRaw.load(std::memory_order_relaxed);
+    RatesMessagesIn_ = Stats_.MessagesIn.load(std::memory_order_relaxed);
+    std::uint64_t Time{0};
+    std::uint64_t Count{0};
+    NetworkMessage Message;
+
+    PayloadPool::acquire(Message.Payload);
+    while (IsReplaying_ && Log.read(Time, Message.IsBinary, Message.Payload))
+    {
+        if (_Speed > 0.0)
+        {
+            std::this_thread::sleep_until(Start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                                      std::chrono::nanoseconds(Time) / _Speed));
+        }
+        Stats_.BytesRaw.fetch_add(Message.Payload.size(), std::memory_order_relaxed);
+        Stats_.MessagesIn.fetch_add(1, std::memory_order_relaxed);
+        if (Message.Payload.size() > Stats_.MessageSizeInMax.load(std::memory_order_relaxed))
+            Stats_.MessageSizeInMax.store(Message.Payload.size(), std::memory_order_relaxed);
+
+        Message.Sequence = InputSequence_++;
+        Message.Timestamp = std::chrono::steady_clock::now();
+        // No timer without connection, sample along with the messages
+        if (Message.Timestamp - RatesTime_ >= std::chrono::milliseconds(RATES_PERIOD))
+            this->sampleRates(Message.Timestamp);
+        InputQueue_->enqueue(std::move(Message));
+        ++Count;
+
+        Message = NetworkMessage();
+        PayloadPool::acquire(Message.Payload);
+    }
+    if (Log.isCorrupt())
+    {
+        Messages.report("net", "Session log " + _File + " is corrupt after " + std::to_string(Count) +
+                        " messages, stopping replay", MessageHandler::ERROR);
+    }
+    Messages.report("net", "Replay finished after " + std::to_string(Count) + " messages and " +
+                    std::to_string(std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count()) +
+                    " s", MessageHandler::INFO);
+    this->clearRates();
+    IsReplaying_.store(false);
+}
+
 void NetworkManager::run()
 {
     auto& Messages = Reg_.ctx<MessageHandler>();
@@ -141,52 +443,133 @@ void NetworkManager::run()
 
     while (IsRunning_)
     {
+        // Sleep until there is something to send or the connection state
+        // changed, no polling
+        OutgoingMessage Message;
+        OutputQueue_->waitDequeue(Message);
+
+        // Without batching, messages are sent right away. Otherwise, they
+        // are collected until the end of the tick
+        if (!Message.Payload.empty())
+        {
+            Unsent_.push_back(std::move(Message));
+            Stats_.Unsent.store(Unsent_.size(), std::memory_order_relaxed);
+            if (IsBatching_) continue;
+        }
+        if (!IsConnected_ || Unsent_.empty()) continue;
+
         NetworkTimer.start();
-        // Check, if there are any errors or messages from
-        // websocketpp.
-        // Since output is transferred to a (string-)stream,
-        // it's content is frequently checked
-        if (!ErrorStream_.str().empty())
+        const std::size_t BatchSize = IsBatching_ ? BATCH_SIZE_MAX : 1;
+        for (std::size_t First = 0; First < Unsent_.size(); First += BatchSize)
         {
-            // Extract line by line in case of multiple messages
-            std::string Line;
-            while (std::getline(ErrorStream_, Line, '\n'))
+            const std::size_t Last = std::min(First + BatchSize, Unsent_.size());
+            bool IsSent{false};
+            if (Last - First == 1)
             {
-                Messages.report("net", "WebSocket++: "+Line);
+                DBLK(Messages.report("net", "Sending message", MessageHandler::DEBUG_L2);)
+                DBLK(Messages.report("net", Unsent_[First].Payload, MessageHandler::DEBUG_L3);)
+                IsSent = this->sendFrame(Unsent_[First].Payload);
             }
-            ErrorStream_.str({});
-        }
-        DBLK(
-            if (!MessageStream_.str().empty())
+            else
             {
-                std::string Line;
-                while(std::getline(MessageStream_, Line, '\n'))
+                // JSON-RPC batch, the buffer keeps its capacity
+                Batch_ = "[";
+                for (auto i = First; i < Last; ++i)
                 {
-                    Messages.report("net", "WebSocket++: "+Line, MessageHandler::DEBUG_L1);
+                    if (i > First) Batch_ += ",";
+                    Batch_ += Unsent_[i].Payload;
                 }
-                MessageStream_.str({});
+                Batch_ += "]";
+                DBLK(Messages.report("net", "Sending batch of " + std::to_string(Last - First) + " messages",
+                                     MessageHandler::DEBUG_L2);)
+                DBLK(Messages.report("net", Batch_, MessageHandler::DEBUG_L3);)
+                IsSent = this->sendFrame(Batch_);
             }
-        )
+            if (!IsSent) continue;
 
-        std::string Message;
-        while (IsConnected_ && OutputQueue_->try_dequeue(Message))
-        {
-            DBLK(Messages.report("net", "Sending message", MessageHandler::DEBUG_L2);)
-            DBLK(Messages.report("net", Message, MessageHandler::DEBUG_L3);)
-            websocketpp::lib::error_code ErrorCode;
-            Client_.send(Connection_, Message, websocketpp::frame::opcode::text, ErrorCode);
-            if (ErrorCode)
+            // Messages held back while disconnected are included, as the
+            // latency seen by the user
+            const auto Now = std::chrono::steady_clock::now();
+            for (auto i = First; i < Last; ++i)
             {
-                Messages.report("net", "Sending failed: " + ErrorCode.message());
+                const double Latency = std::chrono::duration<double>(Now - Unsent_[i].Timestamp).count();
+                SendLatencyAvg_.addValue(Latency);
+                if (Latency > Stats_.SendLatencyMax.load(std::memory_order_relaxed))
+                    Stats_.SendLatencyMax.store(Latency, std::memory_order_relaxed);
             }
+            Stats_.SendLatencyAvg.store(SendLatencyAvg_.getAvg(), std::memory_order_relaxed);
+            Stats_.MessagesOut.fetch_add(Last - First, std::memory_order_relaxed);
+            Stats_.FramesOut.fetch_add(1, std::memory_order_relaxed);
         }
+        Unsent_.clear();
+        Stats_.Unsent.store(0, std::memory_order_relaxed);
+
         NetworkTimer.stop();
         TimerNetwork_.addValue(NetworkTimer.elapsed());
-        if (NetworkingStepSize_ - NetworkTimer.elapsed_ms() > 0.0)
-            std::this_thread::sleep_for(std::chrono::milliseconds(NetworkingStepSize_ - int(NetworkTimer.elapsed_ms())));
     }
 }
 
+bool NetworkManager::sendFrame(const std::string& _Payload)
+{
+    websocketpp::lib::error_code ErrorCode;
+    Client_.send(Connection_, _Payload, websocketpp::frame::opcode::text, ErrorCode);
+    if (ErrorCode)
+    {
+        Stats_.SendErrors.fetch_add(1, std::memory_order_relaxed);
+        Reg_.ctx<MessageHandler>().report("net", "Sending failed: " + ErrorCode.message());
+        return false;
+    }
+    Stats_.BytesOut.fetch_add(_Payload.size(), std::memory_order_relaxed);
+    if (_Payload.size() > Stats_.MessageSizeOutMax.load(std::memory_order_relaxed))
+        Stats_.MessageSizeOutMax.store(_Payload.size(), std::memory_order_relaxed);
+    return true;
+}
+
+void NetworkManager::clearRates()
+{
+    Stats_.BytesInRate.store(0.0, std::memory_order_relaxed);
+    Stats_.BytesOutRate.store(0.0, std::memory_order_relaxed);
+    Stats_.MessagesInRate.store(0.0, std::memory_order_relaxed);
+    Stats_.MessagesOutRate.store(0.0, std::memory_order_relaxed);
+}
+
+void NetworkManager::sampleRates(std::chrono::steady_clock::time_point _Now)
+{
+    const double Period = std::chrono::duration<double>(_Now - RatesTime_).count();
+    if (Period <= 0.0) return;
+
+    const auto BytesIn = Stats_.BytesRaw.load(std::memory_order_relaxed);
+    const auto BytesOut = Stats_.BytesOut.load(std::memory_order_relaxed);
+    const auto MessagesIn = Stats_.MessagesIn.load(std::memory_order_relaxed);
+    const auto MessagesOut = Stats_.MessagesOut.load(std::memory_order_relaxed);
+
+    Stats_.BytesInRate.store((BytesIn - RatesBytesIn_) / Period, std::memory_order_relaxed);
+    Stats_.BytesOutRate.store((BytesOut - RatesBytesOut_) / Period, std::memory_order_relaxed);
+    Stats_.MessagesInRate.store((MessagesIn - RatesMessagesIn_) / Period, std::memory_order_relaxed);
+    Stats_.MessagesOutRate.store((MessagesOut - RatesMessagesOut_) / Period, std::memory_order_relaxed);
+    Stats_.InputQueueDepth.store(InputQueue_->size_approx(), std::memory_order_relaxed);
+    Stats_.OutputQueueDepth.store(OutputQueue_->getSizeApprox() + Stats_.Unsent.load(std::memory_order_relaxed),
+                                  std::memory_order_relaxed);
+
+    RatesTime_ = _Now;
+    RatesBytesIn_ = BytesIn;
+    RatesBytesOut_ = BytesOut;
+    RatesMessagesIn_ = MessagesIn;
+    RatesMessagesOut_ = MessagesOut;
+}
+
+void NetworkManager::scheduleRates()
+{
+    // Runs on the websocket client thread, thus no additional thread and
+    // no wakeups while disconnected
+    RatesTimer_ = Client_.set_timer(RATES_PERIOD, [this](const websocketpp::lib::error_code& _ErrorCode)
+    {
+        if (_ErrorCode || !IsConnected_) return;
+        this->sampleRates(std::chrono::steady_clock::now());
+        this->scheduleRates();
+    });
+}
+
 void NetworkManager::reset()
 {
     ThreadClient_.join();
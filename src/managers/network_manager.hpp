@@ -2,7 +2,10 @@
 #define NETWORK_MANAGER_HPP
 
 #include <atomic>
+#include <chrono>
 #include <map>
+#include <mutex>
+#include <random>
 #include <string>
 #include <thread>
 #include <vector>
@@ -10,58 +13,203 @@
 #include <concurrentqueue/concurrentqueue.h>
 #include <entt/entity/registry.hpp>
 
-#define ASIO_STANDALONE
-#include <websocketpp/config/asio_no_tls_client.hpp>
+#include "websocket_config.hpp"
 #include <websocketpp/client.hpp>
 
 #include "avg_filter.hpp"
+#include "network_message.hpp"
+#include "session_log.hpp"
 
 class NetworkManager
 {
 
     public:
 
-        typedef websocketpp::client<websocketpp::config::asio_client> ClientType;
+        typedef websocketpp::client<ClientConfig> ClientType;
+
+        // Written by the websocket client (or replay) and sender threads,
+        // read by any thread
+        struct NetworkStats
+        {
+            // Payload of received messages, after decompression
+            std::atomic<std::uint64_t> BytesRaw{0};
+            // Payload of sent frames, including batch delimiters
+            std::atomic<std::uint64_t> BytesOut{0};
+            std::atomic<std::uint64_t> MessagesIn{0};
+            std::atomic<std::uint64_t> MessagesOut{0};
+            // Frames sent, less than messages if batched
+            std::atomic<std::uint64_t> FramesOut{0};
+            std::atomic<std::uint64_t> SendErrors{0};
+            // Largest payload received and largest frame sent
+            std::atomic<std::size_t> MessageSizeInMax{0};
+            std::atomic<std::size_t> MessageSizeOutMax{0};
+            // Time from enqueueing a message until handed to the connection
+            std::atomic<double> SendLatencyAvg{0.0};
+            std::atomic<double> SendLatencyMax{0.0};
+
+            // Sampled every RATES_PERIOD by the receiving thread while
+            // connected or replaying, zero otherwise
+            std::atomic<double> BytesInRate{0.0};
+            std::atomic<double> BytesOutRate{0.0};
+            std::atomic<double> MessagesInRate{0.0};
+            std::atomic<double> MessagesOutRate{0.0};
+            // Approximate number of messages waiting to be parsed and to be
+            // sent, including those held back until flush or connection
+            std::atomic<std::size_t> InputQueueDepth{0};
+            std::atomic<std::size_t> OutputQueueDepth{0};
+            std::atomic<std::size_t> Unsent{0};
+        };
+
+        // Delay of the first reconnect attempt, doubled for each failed one
+        static constexpr double RECONNECT_DELAY_MIN = 0.5;
+        static constexpr double RECONNECT_DELAY_MAX = 30.0;
+
+        // Maximum number of requests per JSON-RPC batch, bounds frame size
+        static constexpr std::size_t BATCH_SIZE_MAX = 256;
+
+        // Sampling period of rates and queue depths in milliseconds
+        static constexpr long RATES_PERIOD = 1000;
 
         NetworkManager(entt::registry& _Reg) : Reg_(_Reg) {}
 
         double getFrameTime() const {return TimerNetwork_.getAvg();}
 
+        const NetworkStats& getStats() const {return Stats_;}
+
+        // Received payload as transmitted, i.e. compressed if negotiated.
+        // Frame headers are not included
+        std::uint64_t getBytesWire() const;
+        // Accumulated time decompressing received messages
+        double getDecompressTime() const;
+        static constexpr bool isCompressionAvailable()
+        {
+        #ifdef PWNG_WEBSOCKET_COMPRESSION
+            return true;
+        #else
+            return false;
+        #endif
+        }
+
         bool isConnected() const {return IsConnected_;}
         bool isRunning() const {return IsRunning_;}
-
-        bool init(moodycamel::ConcurrentQueue<std::string>* const _InputQueue,
-                  moodycamel::ConcurrentQueue<std::string>* const _OutputQueue);
+        // Connection was lost and is about to be reestablished
+        bool isReconnecting() const {return IsReconnecting_;}
+        int getReconnectAttempts() const {return ReconnectAttempts_;}
+        void setReconnect(bool _IsEnabled) {IsReconnectEnabled_.store(_IsEnabled);}
+        // Send requests of a tick as JSON-RPC batch at the end of the tick,
+        // for servers supporting it. Otherwise, requests are sent right away
+        void setBatching(bool _IsEnabled) {IsBatching_.store(_IsEnabled);}
+        bool isBatching() const {return IsBatching_;}
+
+        bool init(moodycamel::BlockingConcurrentQueue<NetworkMessage>* const _InputQueue,
+                  OutgoingQueue* const _OutputQueue);
 
                 void addListenerDisconnect(std::function<void(void)> f)
                 {
                         ListenersDisconnect.push_back(f);
                 }
+        // Connection lost unexpectedly, reconnecting. Disconnect listeners
+        // are only called if the session ends, i.e. on request of the user
+        // or if reconnecting was stopped
+        void addListenerConnectionLost(std::function<void(void)> _f)
+        {
+            ListenersConnectionLost_.push_back(_f);
+        }
+        void addListenerReconnect(std::function<void(void)> _f)
+        {
+            ListenersReconnect_.push_back(_f);
+        }
         bool connect(const std::string& _Uri);
+        // Schedule and start reconnect attempts, to be called regularly by
+        // the same thread as connect/disconnect, e.g. once per frame
+        void processReconnect();
+        void cancelReconnect();
+        // Report log records of websocketpp, to be called regularly by a
+        // single thread, e.g. once per frame
+        void processLog();
         bool disconnect();
         void quit();
 
+        // Append all received frames to a session log
+        bool startRecording(const std::string& _File);
+        void stopRecording();
+
+        // Feed a recorded session into the input queue without a network
+        // connection. Speed is a factor of the original rate, 0 replays as
+        // fast as possible
+        bool startReplay(const std::string& _File, double _Speed = 1.0);
+        void stopReplay();
+        bool isReplaying() const {return IsReplaying_;}
+
     private:
 
         void onClose(websocketpp::connection_hdl);
         void onFail();
         void onMessage(websocketpp::connection_hdl, ClientType::message_ptr _Msg);
         bool onOpen(websocketpp::connection_hdl);
+        bool open(const std::string& _Uri);
+        void replay(std::string _File, double _Speed);
         void run();
+        bool sendFrame(const std::string& _Payload);
+        void clearRates();
+        void sampleRates(std::chrono::steady_clock::time_point _Now);
+        void scheduleRates();
         void reset();
 
         entt::registry& Reg_;
 
-        std::stringstream ErrorStream_;
-        std::stringstream MessageStream_;
+        // Drops of websocketpp log records already reported
+        std::uint64_t LogDropped_{0};
+
+        moodycamel::BlockingConcurrentQueue<NetworkMessage>* InputQueue_;
+        OutgoingQueue* OutputQueue_;
+
+        std::uint64_t InputSequence_{0};
+
+        NetworkStats Stats_;
+
+        std::mutex RecordMutex_;
+        SessionLogWriter Record_;
+        std::chrono::steady_clock::time_point RecordStart_;
+        std::atomic<bool> IsRecording_{false};
+
+        std::thread ThreadReplay_;
+        std::atomic<bool> IsReplaying_{false};
+
+        // Messages enqueued during the current tick (if batching) or while
+        // not connected, sent on flush once connected
+        std::vector<OutgoingMessage> Unsent_;
+        std::string Batch_;
+        // Off by default, servers without batch support drop batches
+        // entirely, including subscriptions
+        std::atomic<bool> IsBatching_{false};
 
-        moodycamel::ConcurrentQueue<std::string>* InputQueue_;
-        moodycamel::ConcurrentQueue<std::string>* OutputQueue_;
+        // Counters of the previous sample, owned by the sampling thread
+        ClientType::timer_ptr RatesTimer_;
+        std::chrono::steady_clock::time_point RatesTime_;
+        std::uint64_t RatesBytesIn_{0};
+        std::uint64_t RatesBytesOut_{0};
+        std::uint64_t RatesMessagesIn_{0};
+        std::uint64_t RatesMessagesOut_{0};
 
-        std::uint32_t NetworkingStepSize_{10};
         AvgFilter<double> TimerNetwork_{50};
+        AvgFilter<double> SendLatencyAvg_{50};
 
         std::vector<std::function<void(void)>> ListenersDisconnect;
+        std::vector<std::function<void(void)>> ListenersConnectionLost_;
+        std::vector<std::function<void(void)>> ListenersReconnect_;
+
+        // Reconnect state, flags are set by the websocket client thread,
+        // attempts are scheduled and started by processReconnect
+        std::string Uri_;
+        std::atomic<bool> IsDisconnectRequested_{false};
+        std::atomic<bool> IsReconnectDue_{false};
+        std::atomic<bool> IsReconnectEnabled_{true};
+        std::atomic<bool> IsReconnecting_{false};
+        std::atomic<int> ReconnectAttempts_{0};
+        bool IsReconnectScheduled_{false};
+        std::chrono::steady_clock::time_point ReconnectTime_;
+        std::minstd_rand ReconnectJitter_{std::random_device{}()};
 
         ClientType Client_;
         websocketpp::connection_hdl Connection_;
@@ -0,0 +1,208 @@
+#include "parser_manager.hpp"
+
+#include <rapidjson/error/en.h>
+
+#include "avg_filter.hpp"
+#include "message_handler.hpp"
+#include "method_dispatcher.hpp"
+#include "timer.hpp"
+
+bool ParserManager::init(moodycamel::BlockingConcurrentQueue<NetworkMessage>* const _InputQueue,
+                         int _Workers)
+{
+    auto& Messages = Reg_.ctx<MessageHandler>();
+
+    InputQueue_ = _InputQueue;
+
+    if (_Workers < 1 || _Workers > PerformanceTimers::PARSER_WORKERS_MAX)
+    {
+        Messages.report("prg", "Invalid number of parser workers: " + std::to_string(_Workers) +
+                        ", using 1", MessageHandler::WARNING);
+        _Workers = 1;
+    }
+
+    IsRunning_.store(true);
+    Timers_.ParseWorkers.store(_Workers);
+    for (auto i=0; i<_Workers; ++i)
+    {
+        Workers_.emplace_back(&ParserManager::run, this, i);
+    }
+    DBLK(Messages.report("prg", "Started " + std::to_string(_Workers) + " parser workers", MessageHandler::DEBUG_L1);)
+
+    return true;
+}
+
+void ParserManager::quit()
+{
+    IsRunning_.store(false);
+    // Wake workers waiting for a document buffer, those waiting for
+    // messages notice within WAIT_MAX
+    for (auto i=0u; i<Workers_.size(); ++i) FreeDocuments_.enqueue(nullptr);
+    for (auto& Worker : Workers_)
+    {
+        if (Worker.joinable()) Worker.join();
+    }
+    Workers_.clear();
+}
+
+bool ParserManager::tryDequeue(NetworkDocument& _Doc)
+{
+    if (ReorderedCount_ > 0)
+    {
+        auto& Slot = Reordered_[NextSequence_ & (Reordered_.size()-1)];
+        if (Slot.IsValid)
+        {
+            _Doc = std::move(Slot.Doc);
+            Slot.IsValid = false;
+            --ReorderedCount_;
+            ++NextSequence_;
+            return true;
+        }
+    }
+    while (DocumentQueue_.try_dequeue(_Doc))
+    {
+        if (_Doc.Sequence == NextSequence_)
+        {
+            ++NextSequence_;
+            return true;
+        }
+        this->reorder(std::move(_Doc));
+    }
+    return false;
+}
+
+std::size_t ParserManager::getQueueDepth() const
+{
+    return InputQueue_->size_approx() + DocumentQueue_.size_approx() + ReorderedCount_;
+}
+
+DocumentBuffer* ParserManager::acquireDocument()
+{
+    // Null buffers are only enqueued by quit() to wake waiting workers
+    DocumentBuffer* Doc{nullptr};
+    while (FreeDocuments_.try_dequeue(Doc))
+    {
+        if (Doc != nullptr) return Doc;
+    }
+    {
+        std::lock_guard<std::mutex> Lock(DocumentsMutex_);
+        if (Documents_.size() < DOCUMENTS_MAX)
+        {
+            Documents_.push_back(std::make_unique<DocumentBuffer>());
+            Timers_.ParseAllocations.fetch_add(1, std::memory_order_relaxed);
+            return Documents_.back().get();
+        }
+    }
+    // All buffers in flight, wait for the render thread to recycle one
+    while (IsRunning_)
+    {
+        if (FreeDocuments_.wait_dequeue_timed(Doc, WAIT_MAX) && Doc != nullptr) return Doc;
+    }
+    return nullptr;
+}
+
+void ParserManager::reorder(NetworkDocument&& _Doc)
+{
+    if (_Doc.Sequence - NextSequence_ >= Reordered_.size())
+    {
+        auto Capacity = Reordered_.size();
+        while (_Doc.Sequence - NextSequence_ >= Capacity) Capacity *= 2;
+
+        std::vector<ReorderedSlot> Reordered(Capacity);
+        for (auto& Slot : Reordered_)
+        {
+            if (Slot.IsValid) Reordered[Slot.Doc.Sequence & (Capacity-1)] = std::move(Slot);
+        }
+        Reordered_.swap(Reordered);
+    }
+    auto& Slot = Reordered_[_Doc.Sequence & (Reordered_.size()-1)];
+    Slot.Doc = std::move(_Doc);
+    Slot.IsValid = true;
+    ++ReorderedCount_;
+}
+
+void ParserManager::run(int _Worker)
+{
+    auto& Messages = Reg_.ctx<MessageHandler>();
+    Timer ParseTimer;
+    AvgFilter<double> ParseTimeAvg{50};
+
+    NetworkMessage Message;
+    DocumentPtr Doc(nullptr, DocumentRecycler{&FreeDocuments_});
+    while (IsRunning_)
+    {
+        // Acquire the buffer before taking a message. Otherwise, a worker
+        // could hold the next sequence number while waiting for a buffer,
+        // and all buffers could end up reordered behind it
+        if (!Doc)
+        {
+            Doc = DocumentPtr(this->acquireDocument(), DocumentRecycler{&FreeDocuments_});
+            if (!Doc) break;
+        }
+        if (InputQueue_->wait_dequeue_timed(Message, WAIT_MAX))
+        {
+            if (Message.IsBinary)
+            {
+                DocumentQueue_.enqueue({Message.ClientID, nullptr, Message.Sequence, 0, 0, false, false,
+                                        std::move(Message.Payload), Message.Timestamp});
+                continue;
+            }
+
+            ParseTimer.start();
+
+            // Parse in-situ, strings of the document point into the buffer
+            Doc->Buffer.swap(Message.Payload);
+            PayloadPool::release(std::move(Message.Payload));
+            auto& d = Doc->Document;
+            rapidjson::ParseResult r = d.ParseInsitu(&Doc->Buffer[0]);
+
+            entt::id_type Method{0};
+            std::uint32_t Eid{0};
+            bool IsCoalescible{false};
+            bool IsDelta{false};
+            if (r && d.IsObject())
+            {
+                auto it = d.FindMember("method");
+                if (it != d.MemberEnd() && it->value.IsString())
+                {
+                    Method = MethodDispatcher::hash(it->value.GetString(), it->value.GetStringLength());
+                }
+                if (Method == METHOD_DYNAMIC_DATA || Method == METHOD_TIRE_DATA)
+                {
+                    auto itp = d.FindMember("params");
+                    if (itp != d.MemberEnd() && itp->value.IsObject())
+                    {
+                        auto ite = itp->value.FindMember("eid");
+                        if (ite != itp->value.MemberEnd() && ite->value.IsUint())
+                        {
+                            Eid = ite->value.GetUint();
+                            IsCoalescible = true;
+                        }
+                        // Deltas have a sequence number but no keyframe flag
+                        if (itp->value.HasMember("seq"))
+                        {
+                            auto itk = itp->value.FindMember("kf");
+                            IsDelta = (itk == itp->value.MemberEnd() || !itk->value.IsTrue());
+                        }
+                    }
+                }
+            }
+
+            ParseTimer.stop();
+            ParseTimeAvg.addValue(ParseTimer.elapsed());
+            Timers_.ParseAvg[_Worker].store(ParseTimeAvg.getAvg(), std::memory_order_relaxed);
+
+            if (Doc->hasOverflow()) Timers_.ParseAllocations.fetch_add(1, std::memory_order_relaxed);
+
+            if (!r)
+            {
+                Messages.report("prg", "Parse error: "+std::string(rapidjson::GetParseError_En(r.Code())), MessageHandler::ERROR);
+                // Still pass on an empty document, otherwise the render
+                // thread would wait for this sequence number forever
+                Doc.reset();
+            }
+            DocumentQueue_.enqueue({Message.ClientID, std::move(Doc), Message.Sequence, Method,
+                                    Eid, IsCoalescible, IsDelta, std::string(), Message.Timestamp});
+        }
+    }
+}
@@ -0,0 +1,92 @@
+#ifndef PARSER_MANAGER_HPP
+#define PARSER_MANAGER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <concurrentqueue/blockingconcurrentqueue.h>
+#include <concurrentqueue/concurrentqueue.h>
+#include <entt/core/hashed_string.hpp>
+#include <entt/entity/registry.hpp>
+
+#include "network_message.hpp"
+#include "performance_timers.hpp"
+
+// Parses incoming JSON messages on a small pool of worker threads, so the
+// render thread only has to apply documents to the registry
+class ParserManager
+{
+
+    public:
+
+        // Upper bound of documents in flight. If the render thread lags
+        // behind, workers wait for documents to be recycled
+        static constexpr std::size_t DOCUMENTS_MAX = 2048;
+
+        // Notifications carrying the full state of an entity, older ones
+        // are superseded by later ones of the same entity
+        static constexpr entt::id_type METHOD_DYNAMIC_DATA = entt::hashed_string::value("bc_dynamic_data");
+        static constexpr entt::id_type METHOD_TIRE_DATA = entt::hashed_string::value("tire_data");
+
+        explicit ParserManager(entt::registry& _Reg, PerformanceTimers& _Timers) :
+                Reg_(_Reg),
+                Timers_(_Timers) {}
+        ~ParserManager() {this->quit();}
+
+        bool init(moodycamel::BlockingConcurrentQueue<NetworkMessage>* const _InputQueue,
+                  int _Workers = 2);
+        void quit();
+
+        // Dequeue next document in order of reception, to be called from
+        // the render thread only
+        bool tryDequeue(NetworkDocument& _Doc);
+
+        // Approximate number of messages waiting to be parsed or applied
+        std::size_t getQueueDepth() const;
+
+    private:
+
+        DocumentBuffer* acquireDocument();
+        void reorder(NetworkDocument&& _Doc);
+        void run(int _Worker);
+
+        entt::registry& Reg_;
+        PerformanceTimers& Timers_;
+
+        moodycamel::BlockingConcurrentQueue<NetworkMessage>* InputQueue_{nullptr};
+
+        // Declared before queues holding documents, so recycling on
+        // destruction still finds the pool
+        std::mutex DocumentsMutex_;
+        std::vector<std::unique_ptr<DocumentBuffer>> Documents_;
+        moodycamel::BlockingConcurrentQueue<DocumentBuffer*> FreeDocuments_;
+
+        moodycamel::ConcurrentQueue<NetworkDocument> DocumentQueue_;
+
+        // Documents finished ahead of their predecessors, in a ring indexed
+        // by sequence number, starting at the next one. Grows if a slow
+        // parse is overtaken by more documents than it holds (power of 2)
+        static constexpr std::size_t REORDERED_CAPACITY_INITIAL = 64;
+        struct ReorderedSlot
+        {
+            NetworkDocument Doc;
+            bool IsValid{false};
+        };
+        std::vector<ReorderedSlot> Reordered_ = std::vector<ReorderedSlot>(REORDERED_CAPACITY_INITIAL);
+        std::size_t ReorderedCount_{0};
+        std::uint64_t NextSequence_{0};
+
+        // Idle workers block on the queues, but wake up regularly to notice
+        // quit() even if nothing arrives
+        static constexpr std::chrono::milliseconds WAIT_MAX{100};
+
+        std::vector<std::thread> Workers_;
+
+        std::atomic<bool> IsRunning_{false};
+};
+
+#endif // PARSER_MANAGER_HPP
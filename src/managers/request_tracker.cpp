@@ -0,0 +1,102 @@
+#include "request_tracker.hpp"
+
+#include <algorithm>
+
+#include "message_handler.hpp"
+
+double RequestTracker::MethodStats::getPercentile(double _p) const
+{
+    if (Count == 0) return 0.0;
+
+    const auto Rank = static_cast<std::uint64_t>(_p * Count);
+    std::uint64_t n{0};
+    for (auto i=0u; i<BUCKETS-1; ++i)
+    {
+        n += Histogram[i];
+        if (n > Rank) return std::min(MethodStats::getBucketBound(i), Max);
+    }
+    return Max;
+}
+
+void RequestTracker::track(RequestIDType _Id, const std::string& _Method)
+{
+    auto it = Index_.find(_Method);
+    if (it == Index_.end())
+    {
+        it = Index_.insert({_Method, Stats_.size()}).first;
+        Stats_.emplace_back();
+        Stats_.back().Name = _Method;
+    }
+
+    PendingRequest Request;
+    Request.Method = it->second;
+    Request.Sent = std::chrono::steady_clock::now();
+    Request.Deadline = Request.Sent + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                          std::chrono::duration<double>(TIMEOUT_DEFAULT));
+    Pending_[_Id] = std::move(Request);
+}
+
+void RequestTracker::onResponse(RequestIDType _Id, CallbackType _f, double _Timeout)
+{
+    auto it = Pending_.find(_Id);
+    if (it == Pending_.end()) return;
+
+    it->second.Callback = std::move(_f);
+    if (_Timeout == TIMEOUT_NONE)
+        it->second.Deadline = std::chrono::steady_clock::time_point::max();
+    else
+        it->second.Deadline = it->second.Sent + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                                    std::chrono::duration<double>(_Timeout));
+}
+
+bool RequestTracker::complete(RequestIDType _Id, StatusE _Status, const rapidjson::Value& _Response)
+{
+    auto it = Pending_.find(_Id);
+    if (it == Pending_.end())
+    {
+        ++Unmatched_;
+        return false;
+    }
+
+    const double t = std::chrono::duration<double>(std::chrono::steady_clock::now() - it->second.Sent).count();
+
+    auto& Stats = Stats_[it->second.Method];
+    std::size_t Bucket{0};
+    while (Bucket < MethodStats::BUCKETS-1 && t > MethodStats::getBucketBound(Bucket)) ++Bucket;
+    ++Stats.Histogram[Bucket];
+    ++Stats.Count;
+    Stats.Sum += t;
+    if (t > Stats.Max) Stats.Max = t;
+    if (_Status == StatusE::ERROR) ++Stats.Errors;
+
+    // Callback might create new requests, hence remove pending one first
+    auto Callback = std::move(it->second.Callback);
+    Pending_.erase(it);
+    if (Callback) Callback(_Status, _Response);
+    return true;
+}
+
+void RequestTracker::processTimeouts()
+{
+    if (Pending_.empty()) return;
+
+    static const rapidjson::Value Null;
+    const auto Now = std::chrono::steady_clock::now();
+
+    std::vector<CallbackType> Callbacks;
+    for (auto it = Pending_.begin(); it != Pending_.end();)
+    {
+        if (Now < it->second.Deadline)
+        {
+            ++it;
+            continue;
+        }
+        auto& Stats = Stats_[it->second.Method];
+        ++Stats.Timeouts;
+        DBLK(Reg_.ctx<MessageHandler>().report("net", "Request " + std::to_string(it->first) + " (" +
+                                               Stats.Name + ") timed out", MessageHandler::DEBUG_L1);)
+        if (it->second.Callback) Callbacks.push_back(std::move(it->second.Callback));
+        it = Pending_.erase(it);
+    }
+    for (auto& Callback : Callbacks) Callback(StatusE::TIMEOUT, Null);
+}
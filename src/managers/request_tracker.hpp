@@ -0,0 +1,102 @@
+#ifndef REQUEST_TRACKER_HPP
+#define REQUEST_TRACKER_HPP
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <entt/entity/registry.hpp>
+#include <rapidjson/document.h>
+
+#include "json_manager.hpp"
+
+// Matches JSON-RPC responses to the requests sent, by request id. Measures
+// the round trip time per method (as seen by the client, i.e. including
+// the send queue), calls completion callbacks and times out requests the
+// server doesn't answer. Not thread safe, requests are created and
+// responses applied by the render (main) thread.
+class RequestTracker
+{
+
+    public:
+
+        using RequestIDType = JsonManager::RequestIDType;
+
+        enum class StatusE : int
+        {
+            SUCCESS,
+            ERROR,
+            TIMEOUT
+        };
+
+        // Response is the "result" or "error" value, null on timeout
+        using CallbackType = std::function<void(StatusE _Status, const rapidjson::Value& _Response)>;
+
+        static constexpr double TIMEOUT_DEFAULT = 5.0;
+        // Wait for the response as long as it takes
+        static constexpr double TIMEOUT_NONE = 0.0;
+
+        // Round trip times of one method. Buckets are logarithmic, upper
+        // bound of bucket i is 0.25 ms * 2^i, the last one is open
+        struct MethodStats
+        {
+            static constexpr std::size_t BUCKETS = 16;
+
+            static double getBucketBound(std::size_t _i) {return 0.25e-3 * double(1u << _i);}
+
+            double getAvg() const {return Count > 0 ? Sum / Count : 0.0;}
+            // Upper bound of the bucket holding the given quantile
+            double getPercentile(double _p) const;
+
+            std::string Name;
+            std::array<std::uint64_t, BUCKETS> Histogram{};
+            std::uint64_t Count{0};
+            std::uint64_t Errors{0};
+            std::uint64_t Timeouts{0};
+            double Sum{0.0};
+            double Max{0.0};
+        };
+
+        explicit RequestTracker(entt::registry& _Reg) : Reg_(_Reg) {}
+
+        // Called by the sender for each request, with the id returned by
+        // JsonManager::finalise()
+        void track(RequestIDType _Id, const std::string& _Method);
+        // Callback of a tracked request, e.g. with JsonManager::getRequestID()
+        // right after finalising it. Replaces the default timeout
+        void onResponse(RequestIDType _Id, CallbackType _f, double _Timeout = TIMEOUT_DEFAULT);
+
+        // Returns false if there is no pending request of the given id, e.g.
+        // if it timed out already
+        bool complete(RequestIDType _Id, StatusE _Status, const rapidjson::Value& _Response);
+        void processTimeouts();
+
+        std::size_t getPendingCount() const {return Pending_.size();}
+        std::uint64_t getUnmatchedCount() const {return Unmatched_;}
+        const std::vector<MethodStats>& getStats() const {return Stats_;}
+
+    private:
+
+        struct PendingRequest
+        {
+            std::size_t Method{0};
+            std::chrono::steady_clock::time_point Sent;
+            std::chrono::steady_clock::time_point Deadline;
+            CallbackType Callback;
+        };
+
+        entt::registry& Reg_;
+
+        std::unordered_map<RequestIDType, PendingRequest> Pending_;
+        std::unordered_map<std::string, std::size_t> Index_;
+        std::vector<MethodStats> Stats_;
+
+        // Responses without pending request, e.g. late ones
+        std::uint64_t Unmatched_{0};
+};
+
+#endif // REQUEST_TRACKER_HPP
@@ -0,0 +1,132 @@
+#include "subscription_manager.hpp"
+
+#include "galaxy_cache.hpp"
+#include "ingest_manager.hpp"
+#include "json_manager.hpp"
+#include "message_handler.hpp"
+#include "network_manager.hpp"
+#include "request_tracker.hpp"
+
+void SubscriptionManager::subscribe(const std::string& _Name)
+{
+    Topics_.insert(_Name);
+    if (this->isSending()) this->sendSubscribe(_Name);
+}
+
+void SubscriptionManager::unsubscribe(const std::string& _Name)
+{
+    auto& Json = Reg_.ctx<JsonManager>();
+
+    Topics_.erase(_Name);
+    if (!this->isSending()) return;
+
+    std::string Name = _Name;
+    Name.replace(0, 3, "uns");
+    const auto Id = Json.createRequest(Name)
+        .finalise();
+    OutputQueue_->enqueue(Json.getString());
+    Reg_.ctx<RequestTracker>().track(Id, Name);
+}
+
+void SubscriptionManager::subscribeSystem(const std::string& _Name)
+{
+    Systems_.insert(_Name);
+    if (this->isSending()) this->sendSystem("sub_system", _Name);
+}
+
+void SubscriptionManager::unsubscribeSystem(const std::string& _Name)
+{
+    Systems_.erase(_Name);
+    if (this->isSending()) this->sendSystem("unsub_system", _Name);
+}
+
+void SubscriptionManager::setWireFormat(bool _IsBinary)
+{
+    IsWireFormatBinary_ = _IsBinary;
+    if (this->isSending()) this->sendWireFormat();
+}
+
+void SubscriptionManager::resume()
+{
+    auto& Messages = Reg_.ctx<MessageHandler>();
+
+    Messages.report("net", "Resuming " + std::to_string(Topics_.size()) + " subscriptions and " +
+                    std::to_string(Systems_.size()) + " star systems", MessageHandler::INFO);
+
+    // Wire format first, the server encodes notifications accordingly
+    if (IsWireFormatBinary_) this->sendWireFormat();
+    for (const auto& Topic : Topics_) this->sendSubscribe(Topic);
+    for (const auto& System : Systems_) this->sendSystem("sub_system", System);
+}
+
+void SubscriptionManager::clear()
+{
+    Topics_.clear();
+    Systems_.clear();
+    IsWireFormatBinary_ = false;
+}
+
+bool SubscriptionManager::isSending() const
+{
+    // While reconnecting requests are only recorded, they are sent by
+    // resume() once reconnected. Otherwise they'd be sent twice, since
+    // unsent messages are kept until the connection is open
+    return !Reg_.ctx<NetworkManager>().isReconnecting();
+}
+
+void SubscriptionManager::sendSubscribe(const std::string& _Name)
+{
+    auto& Json = Reg_.ctx<JsonManager>();
+
+    Json.createRequest(_Name);
+    // Offer batched galaxy transfer, servers not knowing the parameter
+    // fall back to one message per star
+    if (_Name == "sub_galaxy_data_evt")
+    {
+        Json.addParam("batch_size", GALAXY_BATCH_SIZE);
+        // Servers knowing the galaxy of the cache only stream what differs
+        const auto& Hash = Reg_.ctx<GalaxyCache>().getHash();
+        if (!Hash.empty()) Json.addParam("cache_hash", Hash);
+    }
+    const auto Id = Json.finalise();
+    OutputQueue_->enqueue(Json.getString());
+
+    auto& Tracker = Reg_.ctx<RequestTracker>();
+    Tracker.track(Id, _Name);
+
+    // Galaxy subscription is answered once the galaxy was transferred,
+    // which may take arbitrarily long, hence it doesn't time out. Otherwise
+    // the answer would be unmatched and the galaxy never finished
+    if (_Name == "sub_galaxy_data_evt")
+    {
+        Tracker.onResponse(Id,
+            [this](RequestTracker::StatusE _Status, const rapidjson::Value&)
+            {
+                if (_Status == RequestTracker::StatusE::SUCCESS) Reg_.ctx<IngestManager>().finishGalaxyTransfer();
+            }, RequestTracker::TIMEOUT_NONE);
+    }
+}
+
+void SubscriptionManager::sendSystem(const char* _Method, const std::string& _Name)
+{
+    auto& Json = Reg_.ctx<JsonManager>();
+
+    const auto Id = Json.createRequest(_Method)
+        .addParam("name", _Name)
+        .finalise();
+    OutputQueue_->enqueue(Json.getString());
+    Reg_.ctx<RequestTracker>().track(Id, _Method);
+}
+
+void SubscriptionManager::sendWireFormat()
+{
+    auto& Json = Reg_.ctx<JsonManager>();
+
+    // High volume notifications may be sent as binary frames, control
+    // messages stay JSON-RPC
+    const auto Id = Json.createRequest("cmd_wire_format")
+        .addParam("format", IsWireFormatBinary_ ? "binary" : "json")
+        .finalise();
+    OutputQueue_->enqueue(Json.getString());
+    Reg_.ctx<RequestTracker>().track(Id, "cmd_wire_format");
+}
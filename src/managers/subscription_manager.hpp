@@ -0,0 +1,58 @@
+#ifndef SUBSCRIPTION_MANAGER_HPP
+#define SUBSCRIPTION_MANAGER_HPP
+
+#include <cstdint>
+#include <set>
+#include <string>
+
+#include <entt/entity/registry.hpp>
+
+#include "network_message.hpp"
+
+// Sends subscription requests and keeps a record of the active ones
+// (topics, star systems and wire format), so that they can be resumed
+// after the connection was lost and reestablished
+class SubscriptionManager
+{
+
+    public:
+
+        // Maximum number of stars per message offered to the server
+        static constexpr std::uint32_t GALAXY_BATCH_SIZE{1024};
+
+        explicit SubscriptionManager(entt::registry& _Reg) : Reg_(_Reg) {}
+
+        void init(OutgoingQueue* const _OutputQueue) {OutputQueue_ = _OutputQueue;}
+
+        // Topics by name of their subscription, e.g. "sub_galaxy_data_evt"
+        void subscribe(const std::string& _Name);
+        void unsubscribe(const std::string& _Name);
+        void subscribeSystem(const std::string& _Name);
+        void unsubscribeSystem(const std::string& _Name);
+        void setWireFormat(bool _IsBinary);
+
+        // Send all recorded requests again, to be called once reconnected
+        void resume();
+        // Forget all subscriptions, e.g. when the session ended
+        void clear();
+
+        bool isSubscribed(const std::string& _Name) const {return Topics_.count(_Name) > 0;}
+        bool isWireFormatBinary() const {return IsWireFormatBinary_;}
+
+    private:
+
+        bool isSending() const;
+        void sendSubscribe(const std::string& _Name);
+        void sendSystem(const char* _Method, const std::string& _Name);
+        void sendWireFormat();
+
+        entt::registry& Reg_;
+
+        OutgoingQueue* OutputQueue_{nullptr};
+
+        std::set<std::string> Topics_;
+        std::set<std::string> Systems_;
+        bool IsWireFormatBinary_{false};
+};
+
+#endif // SUBSCRIPTION_MANAGER_HPP
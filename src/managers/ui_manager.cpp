@@ -1,14 +1,34 @@
 #include "ui_manager.hpp"
 
+#include <cfloat>
+
+#include "clock_sync.hpp"
+#include "interest_system.hpp"
 #include "json_manager.hpp"
+#include "method_dispatcher.hpp"
+#include "motion_system.hpp"
 #include "network_manager.hpp"
 #include "render_system.hpp"
+#include "request_tracker.hpp"
+#include "snapshot_system.hpp"
+#include "subscription_manager.hpp"
 
 void UIManager::addCamHook(entt::entity _e, const std::string& _n)
 {
     CamHooks_.insert({_n, _e});
 }
 
+void UIManager::removeCamHook(entt::entity _e)
+{
+    for (auto it = CamHooks_.begin(); it != CamHooks_.end();)
+    {
+        if (it->second == _e)
+            it = CamHooks_.erase(it);
+        else
+            ++it;
+    }
+}
+
 void UIManager::addSystem(entt::entity _e, const std::string& _n)
 {
     NamesSubSystemsSet_.insert(_n);
@@ -95,8 +115,106 @@ void UIManager::displayPerformance(PerformanceTimers& _Timers)
         ImGui::Text("Frame Time:  %.3f ms; (%.1f FPS)",
                     1000.0/double(ImGui::GetIO().Framerate), double(ImGui::GetIO().Framerate));
         ImGui::Text("Process Queue: %.2f ms", _Timers.QueueAvg.getAvg_ms());
+        float QueueBudget = _Timers.QueueBudget*1000.0;
+        if (ImGui::SliderFloat("Queue Budget [ms]", &QueueBudget, 1.0f, 50.0f, "%.1f"))
+        {
+            _Timers.QueueBudget = QueueBudget/1000.0;
+        }
+        ImGui::Text("- Queue Depth: %lu", static_cast<unsigned long>(_Timers.QueueDepth));
+        ImGui::Text("- Deferred: %lu", static_cast<unsigned long>(_Timers.QueueDeferred));
+        ImGui::Text("- Oldest Message: %.2f ms", _Timers.QueueOldestAge*1000.0);
+        ImGui::Text("- Coalesced: %lu", static_cast<unsigned long>(_Timers.QueueCoalesced));
+        ImGui::Text("- Keyframe Requests: %lu", static_cast<unsigned long>(_Timers.QueueKeyframeRequests));
+        for (auto i=0; i<_Timers.ParseWorkers.load(); ++i)
+        {
+            ImGui::Text("- Parse Worker %d: %.3f ms", i, _Timers.ParseAvg[i].load()*1000.0);
+        }
+        ImGui::Text("- Parse Allocations: %lu",
+                    static_cast<unsigned long>(_Timers.ParseAllocations.load()));
         ImGui::Text("Render (CPU): %.2f ms", _Timers.RenderAvg.getAvg_ms());
         ImGui::Text("Viewport Test: %.2f ms", _Timers.ViewportTestAvg.getAvg_ms());
+        ImGui::Text("Interpolation: %.2f ms", _Timers.MotionAvg.getAvg_ms());
+        ImGui::Text("Snapshots: %.2f ms", _Timers.SnapshotAvg.getAvg_ms());
+    ImGui::Unindent();
+    ImGui::Text("Network:");
+    ImGui::Indent();
+    {
+        const auto& Network = Reg_.ctx<NetworkManager>();
+        const double Raw = Network.getStats().BytesRaw.load();
+        const double Wire = Network.getBytesWire();
+        ImGui::Text("Messages In: %lu", static_cast<unsigned long>(Network.getStats().MessagesIn.load()));
+        ImGui::Text("Messages Out: %lu (%lu frames)", static_cast<unsigned long>(Network.getStats().MessagesOut.load()),
+                    static_cast<unsigned long>(Network.getStats().FramesOut.load()));
+        ImGui::Text("Send Latency: %.3f ms (max %.3f ms)", Network.getStats().SendLatencyAvg.load()*1000.0,
+                    Network.getStats().SendLatencyMax.load()*1000.0);
+        ImGui::Text("Sender: %.2f ms", Network.getFrameTime()*1000.0);
+        ImGui::Text("In:  %.0f msg/s, %.1f KiB/s", Network.getStats().MessagesInRate.load(),
+                    Network.getStats().BytesInRate.load()/1024.0);
+        ImGui::Text("Out: %.0f msg/s, %.1f KiB/s", Network.getStats().MessagesOutRate.load(),
+                    Network.getStats().BytesOutRate.load()/1024.0);
+        ImGui::Text("Queue Depth: in %lu, out %lu",
+                    static_cast<unsigned long>(Network.getStats().InputQueueDepth.load()),
+                    static_cast<unsigned long>(Network.getStats().OutputQueueDepth.load()));
+        ImGui::Text("Largest Message: in %.1f KiB, out %.1f KiB",
+                    Network.getStats().MessageSizeInMax.load()/1024.0,
+                    Network.getStats().MessageSizeOutMax.load()/1024.0);
+        const auto& Clock = Reg_.ctx<ClockSync>();
+        if (Clock.isSynced())
+        {
+            ImGui::Text("Clock Offset: %.3f ms (round trip %.3f ms)", Clock.getOffset()*1000.0,
+                        Clock.getRoundTrip()*1000.0);
+            ImGui::Text("Staleness: %.2f ms (oldest %.2f ms)", Clock.getStaleness()*1000.0,
+                        Clock.getStalenessOldest()*1000.0);
+        }
+        else
+        {
+            ImGui::Text(Clock.isSupported() ? "Clock: not synchronised" : "Clock: not supported by server");
+        }
+        if (Network.getStats().SendErrors.load() > 0)
+            ImGui::TextColored(ImVec4(1.0f, 0.5f, 0.0f, 1.0f), "Send Errors: %lu",
+                               static_cast<unsigned long>(Network.getStats().SendErrors.load()));
+        else
+            ImGui::Text("Send Errors: 0");
+        ImGui::Text("Raw:  %.2f MiB", Raw/(1024.0*1024.0));
+        ImGui::Text("Wire: %.2f MiB (%.1f%%)", Wire/(1024.0*1024.0), Raw > 0.0 ? 100.0*Wire/Raw : 100.0);
+        if (NetworkManager::isCompressionAvailable())
+            ImGui::Text("Decompression: %.2f ms", Network.getDecompressTime()*1000.0);
+        else
+            ImGui::Text("Compression: not compiled in");
+    }
+    ImGui::Unindent();
+    ImGui::Text("Methods:");
+    ImGui::Indent();
+        for (const auto& Method : Reg_.ctx<MethodDispatcher>().getStats())
+        {
+            ImGui::Text("%s: %lu (%.3f ms)", Method.Name.c_str(),
+                        static_cast<unsigned long>(Method.Count), Method.TimeAvg.getAvg_ms());
+        }
+    ImGui::Unindent();
+    ImGui::Text("Requests (round trip):");
+    ImGui::Indent();
+    {
+        const auto& Tracker = Reg_.ctx<RequestTracker>();
+        ImGui::Text("Pending: %lu, Unmatched: %lu", static_cast<unsigned long>(Tracker.getPendingCount()),
+                    static_cast<unsigned long>(Tracker.getUnmatchedCount()));
+        for (const auto& Method : Tracker.getStats())
+        {
+            if (ImGui::TreeNode(Method.Name.c_str(), "%s: %lu (%.2f ms, p99 %.2f ms)", Method.Name.c_str(),
+                                static_cast<unsigned long>(Method.Count), Method.getAvg()*1000.0,
+                                Method.getPercentile(0.99)*1000.0))
+            {
+                ImGui::Text("p50 %.2f ms, p90 %.2f ms, max %.2f ms", Method.getPercentile(0.5)*1000.0,
+                            Method.getPercentile(0.9)*1000.0, Method.Max*1000.0);
+                ImGui::Text("Errors: %lu, Timeouts: %lu", static_cast<unsigned long>(Method.Errors),
+                            static_cast<unsigned long>(Method.Timeouts));
+                float Histogram[RequestTracker::MethodStats::BUCKETS];
+                for (auto i=0u; i<RequestTracker::MethodStats::BUCKETS; ++i) Histogram[i] = Method.Histogram[i];
+                ImGui::PlotHistogram("##Latency", Histogram, RequestTracker::MethodStats::BUCKETS, 0,
+                                     "0.25 ms .. >4 s (log2)", 0.0f, FLT_MAX, ImVec2(0, 60));
+                ImGui::TreePop();
+            }
+        }
+    }
     ImGui::Unindent();
     ImGui::Text("Server:");
     ImGui::Indent();
@@ -187,38 +305,100 @@ void UIManager::processCameraHooks(entt::entity _Cam)
 
 void UIManager::processClientControl()
 {
-    auto& Json = Reg_.ctx<JsonManager>();
+    auto& Subscriptions = Reg_.ctx<SubscriptionManager>();
 
     if (ImGui::Button("Subscribe: All"))
     {
-        Json.createRequest("sub_galaxy_data_evt").finalise();
-        QueueOut_->enqueue(Json.getString());
-        Json.createRequest("sub_dynamic_data_evt").finalise();
-        QueueOut_->enqueue(Json.getString());
-        Json.createRequest("sub_perf_stats_s1").finalise();
-        QueueOut_->enqueue(Json.getString());
-        Json.createRequest("sub_sim_stats_s01").finalise();
-        QueueOut_->enqueue(Json.getString());
+        Subscriptions.subscribe("sub_galaxy_data_evt");
+        Subscriptions.subscribe("sub_dynamic_data_evt");
+        Subscriptions.subscribe("sub_perf_stats_s1");
+        Subscriptions.subscribe("sub_sim_stats_s01");
     }
     if (ImGui::Button("Subscribe: Galaxy Data"))
     {
-        Json.createRequest("sub_galaxy_data_evt").finalise();
-        QueueOut_->enqueue(Json.getString());
+        Subscriptions.subscribe("sub_galaxy_data_evt");
     }
     if (ImGui::Button("Subscribe: Dynamic Data"))
     {
-        Json.createRequest("sub_dynamic_data_evt").finalise();
-        QueueOut_->enqueue(Json.getString());
+        Subscriptions.subscribe("sub_dynamic_data_evt");
     }
     if (ImGui::Button("Subscribe: Performance Stats"))
     {
-        Json.createRequest("sub_perf_stats_s1").finalise();
-        QueueOut_->enqueue(Json.getString());
+        Subscriptions.subscribe("sub_perf_stats_s1");
     }
     if (ImGui::Button("Subscribe: Simulation Stats"))
     {
-        Json.createRequest("sub_sim_stats_s01").finalise();
-        QueueOut_->enqueue(Json.getString());
+        Subscriptions.subscribe("sub_sim_stats_s01");
+    }
+    // High volume notifications may be sent as binary frames, control
+    // messages stay JSON-RPC
+    bool IsWireFormatBinary = Subscriptions.isWireFormatBinary();
+    if (ImGui::Checkbox("Binary wire format", &IsWireFormatBinary))
+    {
+        Subscriptions.setWireFormat(IsWireFormatBinary);
+    }
+    // Only dynamic objects near the viewport are sent by the server
+    auto& Interest = Reg_.ctx<InterestSystem>();
+    bool IsInterest = Interest.isEnabled();
+    if (ImGui::Checkbox("Interest region", &IsInterest))
+    {
+        Interest.setEnabled(IsInterest);
+    }
+    if (IsInterest)
+    {
+        ImGui::SameLine();
+        if (Interest.isSupported())
+            ImGui::Text("(%lu updates)", static_cast<unsigned long>(Interest.getUpdates()));
+        else
+            ImGui::Text("(not supported by server)");
+    }
+    // Smooth motion between server updates, allows for lower update rates
+    auto& Motion = Reg_.ctx<MotionSystem>();
+    bool IsInterpolation = Motion.isEnabled();
+    if (ImGui::Checkbox("Interpolate motion", &IsInterpolation))
+    {
+        Motion.setEnabled(IsInterpolation);
+    }
+    if (IsInterpolation)
+    {
+        ImGui::SameLine();
+        ImGui::Text("(delay %.0f ms, %lu extrapolated)", Motion.getDelay()*1000.0,
+                    static_cast<unsigned long>(Motion.getExtrapolated()));
+    }
+    // Requests of a frame are sent as one JSON-RPC batch, only for servers
+    // supporting batches
+    auto& Network = Reg_.ctx<NetworkManager>();
+    bool IsBatching = Network.isBatching();
+    if (ImGui::Checkbox("Batch requests", &IsBatching))
+    {
+        Network.setBatching(IsBatching);
+    }
+    // Review the received state of the last seconds, recording stops
+    // while paused
+    auto& Snapshots = Reg_.ctx<SnapshotSystem>();
+    const auto& Ring = Snapshots.getRing();
+    bool IsPaused = Snapshots.isPaused();
+    if (ImGui::Checkbox("Pause and scrub", &IsPaused))
+    {
+        Snapshots.setPaused(IsPaused);
+    }
+    ImGui::SameLine();
+    ImGui::Text("(%lu snapshots, %.1f of %.1f MiB)", static_cast<unsigned long>(Ring.size()),
+                Ring.getRecords() * SnapshotRing::RECORD_SIZE / (1024.0*1024.0), Ring.getMemory() / (1024.0*1024.0));
+    if (IsPaused && !Ring.empty())
+    {
+        int Selected = static_cast<int>(Snapshots.getSelected());
+        if (ImGui::ArrowButton("##SnapshotPrevious", ImGuiDir_Left) && Selected > 0) --Selected;
+        ImGui::SameLine();
+        if (ImGui::ArrowButton("##SnapshotNext", ImGuiDir_Right)) ++Selected;
+        ImGui::SameLine();
+        ImGui::SliderInt("Snapshot", &Selected, 0, static_cast<int>(Ring.size())-1);
+        Snapshots.select(Selected);
+
+        const auto& s = Ring[Snapshots.getSelected()];
+        ImGui::Text("%.3f s before pausing, %lu objects", Snapshots.getAge(Snapshots.getSelected()),
+                    static_cast<unsigned long>(s.Count));
+        ImGui::Text("Simulation time: %uy %.3fs", s.Years, s.Seconds);
     }
 }
 
@@ -237,6 +417,13 @@ void UIManager::processConnections()
             Reg_.destroy(v.begin(), v.end());
         }
     }
+    else if (Network.isReconnecting())
+    {
+        // Scene is kept (stale) until reconnected
+        ImGui::Text("Connection lost, reconnecting (attempt %d)", Network.getReconnectAttempts()+1);
+        ImGui::SameLine();
+        if (ImGui::Button("Stop")) Network.cancelReconnect();
+    }
     else
     {
         if (ImGui::Button("Connect")) Network.connect(Msg);
@@ -267,6 +454,7 @@ void UIManager::processObjectLabels()
 void UIManager::processServerControl(double _CurrentAcceleration)
 {
     auto& Json = Reg_.ctx<JsonManager>();
+    auto& Tracker = Reg_.ctx<RequestTracker>();
 
     static char Id[10] = "1";
     ImGui::Text("ID     ");
@@ -279,7 +467,7 @@ void UIManager::processServerControl(double _CurrentAcceleration)
     ImGui::SameLine();
     if (ImGui::Button("Send"))
     {
-        Json.createRequest(Msg).finalise();
+        Tracker.track(Json.createRequest(Msg).finalise(), Msg);
         QueueOut_->enqueue(Json.getString());
     }
     static int Acceleration{0};
@@ -289,28 +477,29 @@ void UIManager::processServerControl(double _CurrentAcceleration)
     ImGui::PushItemWidth(100);
     if (ImGui::SliderInt("##acc", &Acceleration, -1, 6, ""))
     {
-        Json.createRequest("cmd_accelerate_simulation")
+        const auto RequestID = Json.createRequest("cmd_accelerate_simulation")
             .beginArray("params")
             .addValue(std::pow(10.0, Acceleration))
             .endArray()
             .finalise();
         QueueOut_->enqueue(std::string(Json.getString()));
+        Tracker.track(RequestID, "cmd_accelerate_simulation");
     }
     ImGui::SameLine();
     ImGui::Text("x%.1f", _CurrentAcceleration);
     if (ImGui::Button("Start Simulation"))
     {
-        Json.createRequest("cmd_start_simulation").finalise();
+        Tracker.track(Json.createRequest("cmd_start_simulation").finalise(), "cmd_start_simulation");
         QueueOut_->enqueue(Json.getString());
     }
     if (ImGui::Button("Stop Simulation"))
     {
-        Json.createRequest("cmd_stop_simulation").finalise();
+        Tracker.track(Json.createRequest("cmd_stop_simulation").finalise(), "cmd_stop_simulation");
         QueueOut_->enqueue(Json.getString());
     }
     if (ImGui::Button("Shutdown Server"))
     {
-        Json.createRequest("cmd_shutdown").finalise();
+        Tracker.track(Json.createRequest("cmd_shutdown").finalise(), "cmd_shutdown");
         QueueOut_->enqueue(Json.getString());
     }
 }
@@ -320,8 +509,6 @@ void UIManager::processSubscriptions()
     static int Subs{0};
     if (ImGui::Combo("Subscribe", &Subs, NamesSubs_))
     {
-        auto& Json = Reg_.ctx<JsonManager>();
-
         std::string Name = NamesSubs_[Subs];
 
         NamesUnsubsSet_.insert(Name);
@@ -330,9 +517,7 @@ void UIManager::processSubscriptions()
         NamesSubs_.assign(NamesSubsSet_.cbegin(), NamesSubsSet_.cend());
         NamesUnsubs_.assign(NamesUnsubsSet_.cbegin(), NamesUnsubsSet_.cend());
 
-        Json.createRequest(Name)
-            .finalise();
-        QueueOut_->enqueue(Json.getString());
+        Reg_.ctx<SubscriptionManager>().subscribe(Name);
 
         Subs = 0;
     }
@@ -340,8 +525,6 @@ void UIManager::processSubscriptions()
     static int Unsubs{0};
     if (ImGui::Combo("Unsubscribe", &Unsubs, NamesUnsubs_))
     {
-        auto& Json = Reg_.ctx<JsonManager>();
-
         std::string Name = NamesUnsubs_[Unsubs];
 
         NamesSubsSet_.insert(Name);
@@ -350,10 +533,7 @@ void UIManager::processSubscriptions()
         NamesSubs_.assign(NamesSubsSet_.cbegin(), NamesSubsSet_.cend());
         NamesUnsubs_.assign(NamesUnsubsSet_.cbegin(), NamesUnsubsSet_.cend());
 
-        Name.replace(0, 3, "uns");
-        Json.createRequest(Name)
-            .finalise();
-        QueueOut_->enqueue(Json.getString());
+        Reg_.ctx<SubscriptionManager>().unsubscribe(Name);
 
         Unsubs = 0;
     }
@@ -364,8 +544,6 @@ void UIManager::processStarSystems()
     static int StarSystemSub{0};
     if (ImGui::Combo("Subscribe System", &StarSystemSub, NamesSubSystems_))
     {
-        auto& Json = Reg_.ctx<JsonManager>();
-
         std::string Name = NamesSubSystems_[StarSystemSub];
 
         NamesUnsubSystemsSet_.insert(Name);
@@ -374,18 +552,13 @@ void UIManager::processStarSystems()
         NamesSubSystems_.assign(NamesSubSystemsSet_.cbegin(), NamesSubSystemsSet_.cend());
         NamesUnsubSystems_.assign(NamesUnsubSystemsSet_.cbegin(), NamesUnsubSystemsSet_.cend());
 
-        Json.createRequest("sub_system")
-            .addParam("name", Name)
-            .finalise();
-        QueueOut_->enqueue(Json.getString());
+        Reg_.ctx<SubscriptionManager>().subscribeSystem(Name);
 
         StarSystemSub = 0;
     }
     static int StarSystemUnsub{0};
     if (ImGui::Combo("Unsubscribe System", &StarSystemUnsub, NamesUnsubSystems_))
     {
-        auto& Json = Reg_.ctx<JsonManager>();
-
         std::string Name = NamesUnsubSystems_[StarSystemUnsub];
 
         NamesSubSystemsSet_.insert(Name);
@@ -394,10 +567,7 @@ void UIManager::processStarSystems()
         NamesSubSystems_.assign(NamesSubSystemsSet_.cbegin(), NamesSubSystemsSet_.cend());
         NamesUnsubSystems_.assign(NamesUnsubSystemsSet_.cbegin(), NamesUnsubSystemsSet_.cend());
 
-        Json.createRequest("unsub_system")
-            .addParam("name", Name)
-            .finalise();
-        QueueOut_->enqueue(Json.getString());
+        Reg_.ctx<SubscriptionManager>().unsubscribeSystem(Name);
 
         StarSystemUnsub = 0;
     }
@@ -12,6 +12,7 @@
 
 #include "components.hpp"
 #include "message_handler.hpp"
+#include "network_message.hpp"
 #include "performance_timers.hpp"
 #include "scale_unit.hpp"
 #include "sim_timer.hpp"
@@ -23,8 +24,8 @@ class UIManager
 
         explicit UIManager(entt::registry& _Reg,
                            Magnum::ImGuiIntegration::Context& _ImGUI,
-                           moodycamel::ConcurrentQueue<std::string>* _QueueIn,
-                           moodycamel::ConcurrentQueue<std::string>* _QueueOut) :
+                           moodycamel::BlockingConcurrentQueue<NetworkMessage>* _QueueIn,
+                           OutgoingQueue* _QueueOut) :
                 Reg_(_Reg),
                 QueueIn_(_QueueIn),
                 QueueOut_(_QueueOut),
@@ -32,6 +33,8 @@ class UIManager
 
         void addCamHook(entt::entity _e, const std::string& _n);
         void addSystem(entt::entity _e, const std::string& _n);
+        // Names are updated by finishSystemsTransfer
+        void removeCamHook(entt::entity _e);
         void cleanupHooks()
         {
             CamHooks_.clear();
@@ -65,8 +68,8 @@ class UIManager
         entt::registry& Reg_;
         Magnum::ImGuiIntegration::Context& ImGUI_;
 
-        moodycamel::ConcurrentQueue<std::string>* QueueIn_;
-        moodycamel::ConcurrentQueue<std::string>* QueueOut_;
+        moodycamel::BlockingConcurrentQueue<NetworkMessage>* QueueIn_;
+        OutgoingQueue* QueueOut_;
 
         std::map<std::string, entt::entity> CamHooks_;
         std::set<std::string> NamesSubSystemsSet_;
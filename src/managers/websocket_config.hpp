@@ -0,0 +1,235 @@
+#ifndef WEBSOCKET_CONFIG_HPP
+#define WEBSOCKET_CONFIG_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#define ASIO_STANDALONE
+#include <websocketpp/config/asio_no_tls_client.hpp>
+#include <websocketpp/message_buffer/message.hpp>
+
+#ifdef PWNG_WEBSOCKET_COMPRESSION
+    #include <websocketpp/extensions/permessage_deflate/enabled.hpp>
+#endif
+
+#include "log_ring.hpp"
+#include "network_message.hpp"
+#include "timer.hpp"
+
+// Log records of websocketpp's access and error logger, drained by
+// NetworkManager::processLog
+inline LogRing& getWebsocketLogRing()
+{
+    static LogRing Ring;
+    return Ring;
+}
+
+// websocketpp logger writing to the LogRing instead of a stream, so the
+// websocket client thread neither blocks nor allocates for logging and no
+// stream is shared between threads. Same interface as
+// websocketpp::log::basic
+template <typename concurrency, typename names>
+class RingLogger
+{
+
+    public:
+
+        typedef websocketpp::log::level level;
+        typedef websocketpp::log::channel_type_hint channel_type_hint;
+
+        explicit RingLogger(channel_type_hint::value _Hint = channel_type_hint::access) :
+            IsError_(_Hint == channel_type_hint::error) {}
+
+        RingLogger(level _Channels, channel_type_hint::value _Hint = channel_type_hint::access) :
+            StaticChannels_(_Channels),
+            IsError_(_Hint == channel_type_hint::error) {}
+
+        void set_channels(level _Channels)
+        {
+            if (_Channels == names::none)
+            {
+                Channels_.store(0, std::memory_order_relaxed);
+                return;
+            }
+            Channels_.fetch_or(_Channels & StaticChannels_, std::memory_order_relaxed);
+        }
+
+        void clear_channels(level _Channels)
+        {
+            Channels_.fetch_and(~_Channels, std::memory_order_relaxed);
+        }
+
+        void write(level _Channel, std::string const& _Msg)
+        {
+            if (!this->dynamic_test(_Channel)) return;
+            getWebsocketLogRing().push(IsError_, _Channel, _Msg.data(), _Msg.size());
+        }
+
+        void write(level _Channel, char const* _Msg)
+        {
+            if (!this->dynamic_test(_Channel)) return;
+            getWebsocketLogRing().push(IsError_, _Channel, _Msg, std::strlen(_Msg));
+        }
+
+        bool static_test(level _Channel) const
+        {
+            return (_Channel & StaticChannels_) != 0;
+        }
+
+        bool dynamic_test(level _Channel)
+        {
+            return (_Channel & Channels_.load(std::memory_order_relaxed)) != 0;
+        }
+
+    private:
+
+        level StaticChannels_{0xffffffff};
+        std::atomic<level> Channels_{0};
+        bool IsError_{false};
+};
+
+// Connection message manager of websocketpp, handing out messages with
+// payload buffers from the PayloadPool. Same interface as
+// websocketpp::message_buffer::alloc::con_msg_manager
+template <typename message>
+class PooledMsgManager : public websocketpp::lib::enable_shared_from_this<PooledMsgManager<message>>
+{
+
+    public:
+
+        typedef PooledMsgManager<message> type;
+        typedef websocketpp::lib::shared_ptr<PooledMsgManager> ptr;
+        typedef websocketpp::lib::weak_ptr<PooledMsgManager> weak_ptr;
+        typedef typename message::ptr message_ptr;
+
+        message_ptr get_message()
+        {
+            return this->get_message(websocketpp::frame::opcode::text, 0);
+        }
+
+        message_ptr get_message(websocketpp::frame::opcode::value _Op, std::size_t _Size)
+        {
+            auto Msg = websocketpp::lib::make_shared<message>(type::shared_from_this(), _Op, 0);
+            auto& Payload = Msg->get_raw_payload();
+            PayloadPool::acquire(Payload);
+            Payload.reserve(_Size);
+            return Msg;
+        }
+
+        bool recycle(message*) {return false;}
+};
+
+template <typename con_msg_manager>
+class PooledEndpointMsgManager
+{
+
+    public:
+
+        typedef typename con_msg_manager::ptr con_msg_man_ptr;
+
+        con_msg_man_ptr get_manager() const
+        {
+            return websocketpp::lib::make_shared<con_msg_manager>();
+        }
+};
+
+// Client config receiving into pooled payload buffers and logging to the
+// LogRing
+struct PooledClientConfig : public websocketpp::config::asio_client
+{
+    typedef PooledClientConfig type;
+    typedef websocketpp::config::asio_client base;
+
+    typedef base::concurrency_type concurrency_type;
+
+    typedef base::request_type request_type;
+    typedef base::response_type response_type;
+
+    typedef websocketpp::message_buffer::message<PooledMsgManager> message_type;
+    typedef PooledMsgManager<message_type> con_msg_manager_type;
+    typedef PooledEndpointMsgManager<con_msg_manager_type> endpoint_msg_manager_type;
+
+    typedef RingLogger<concurrency_type, websocketpp::log::alevel> alog_type;
+    typedef RingLogger<concurrency_type, websocketpp::log::elevel> elog_type;
+
+    typedef base::rng_type rng_type;
+
+    // Transport logs through the same loggers
+    struct transport_config : public base::transport_config
+    {
+        typedef type::alog_type alog_type;
+        typedef type::elog_type elog_type;
+    };
+    typedef websocketpp::transport::asio::endpoint<transport_config> transport_type;
+};
+
+// Counters of the permessage-deflate extension, written by the websocket
+// client thread
+struct DeflateStats
+{
+    std::atomic<std::uint64_t> BytesCompressed{0};
+    std::atomic<std::uint64_t> BytesDecompressed{0};
+    std::atomic<double> DecompressTime{0.0};
+};
+
+#ifdef PWNG_WEBSOCKET_COMPRESSION
+
+// permessage-deflate measuring compressed and decompressed bytes and the
+// time spent decompressing. websocketpp calls the extension through the
+// config's type, hence hiding decompress() is sufficient
+template <typename config>
+class CountingDeflate : public websocketpp::extensions::permessage_deflate::enabled<config>
+{
+
+    public:
+
+        static DeflateStats& getStats()
+        {
+            static DeflateStats Stats;
+            return Stats;
+        }
+
+        websocketpp::lib::error_code decompress(std::uint8_t const* _Buf, std::size_t _Len,
+                                                std::string& _Out)
+        {
+            auto& Stats = CountingDeflate::getStats();
+            const auto Size = _Out.size();
+
+            Timer_.start();
+            auto ErrorCode = websocketpp::extensions::permessage_deflate::enabled<config>::decompress(_Buf, _Len, _Out);
+            Timer_.stop();
+
+            Stats.BytesCompressed.fetch_add(_Len, std::memory_order_relaxed);
+            Stats.BytesDecompressed.fetch_add(_Out.size() - Size, std::memory_order_relaxed);
+            Stats.DecompressTime.store(Stats.DecompressTime.load(std::memory_order_relaxed) + Timer_.elapsed(),
+                                       std::memory_order_relaxed);
+            return ErrorCode;
+        }
+
+    private:
+
+        Timer Timer_;
+};
+
+// Client config offering permessage-deflate to the server
+struct DeflateClientConfig : public PooledClientConfig
+{
+    typedef DeflateClientConfig type;
+    typedef PooledClientConfig base;
+
+    struct permessage_deflate_config {};
+
+    typedef CountingDeflate<permessage_deflate_config> permessage_deflate_type;
+};
+
+typedef DeflateClientConfig ClientConfig;
+
+#else
+
+typedef PooledClientConfig ClientConfig;
+
+#endif // PWNG_WEBSOCKET_COMPRESSION
+
+#endif // WEBSOCKET_CONFIG_HPP
@@ -0,0 +1,93 @@
+#ifndef METHOD_DISPATCHER_HPP
+#define METHOD_DISPATCHER_HPP
+
+#include <cassert>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <entt/core/hashed_string.hpp>
+#include <rapidjson/document.h>
+
+#include "avg_filter.hpp"
+#include "timer.hpp"
+
+// Routes JSON-RPC notifications to registered handlers. Method names are
+// hashed once (usually by parser workers), so dispatching is a single
+// lookup instead of a chain of string compares
+class MethodDispatcher
+{
+
+    public:
+
+        using HandlerType = std::function<void(const rapidjson::Value& _Params)>;
+
+        struct MethodStats
+        {
+            std::string Name;
+            std::uint64_t Count{0};
+            AvgFilter<double> TimeAvg{50};
+        };
+
+        static entt::id_type hash(const char* _Name, std::size_t _Length)
+        {
+            return entt::hashed_string::value(_Name, _Length);
+        }
+
+        // Replaces the handler of a method registered before. Returns false
+        // if the name's hash collides with the one of another method, the
+        // handler of the other method is kept
+        bool registerMethod(const std::string& _Name, HandlerType _Handler)
+        {
+            auto Id = MethodDispatcher::hash(_Name.c_str(), _Name.size());
+            auto it = Index_.find(Id);
+            if (it != Index_.end())
+            {
+                if (Stats_[it->second].Name != _Name)
+                {
+                    assert(false && "Hash collision of method names");
+                    return false;
+                }
+                Handlers_[it->second] = std::move(_Handler);
+            }
+            else
+            {
+                Index_.insert({Id, Handlers_.size()});
+                Handlers_.push_back(std::move(_Handler));
+                Stats_.emplace_back();
+                Stats_.back().Name = _Name;
+            }
+            return true;
+        }
+
+        // Returns false if there is no handler for the given method
+        bool dispatch(entt::id_type _Method, const rapidjson::Value& _Params)
+        {
+            auto it = Index_.find(_Method);
+            if (it == Index_.end()) return false;
+
+            auto& Stats = Stats_[it->second];
+
+            Timer_.start();
+            Handlers_[it->second](_Params);
+            Timer_.stop();
+
+            ++Stats.Count;
+            Stats.TimeAvg.addValue(Timer_.elapsed());
+            return true;
+        }
+
+        const std::vector<MethodStats>& getStats() const {return Stats_;}
+
+    private:
+
+        std::unordered_map<entt::id_type, std::size_t> Index_;
+        std::vector<HandlerType> Handlers_;
+        std::vector<MethodStats> Stats_;
+
+        Timer Timer_;
+};
+
+#endif // METHOD_DISPATCHER_HPP
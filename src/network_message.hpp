@@ -1,23 +1,202 @@
 #ifndef NETWORK_MESSAGE_HPP
 #define NETWORK_MESSAGE_HPP
 
+#include <concurrentqueue/blockingconcurrentqueue.h>
+#include <concurrentqueue/concurrentqueue.h>
 #include <entt/entity/entity.hpp>
 #include <rapidjson/document.h>
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
 #include <string>
 
+// Free list of payload buffers. Buffers are handed to websocketpp for
+// receiving, moved through the queues without copying and returned here
+// once a parsed document or binary message was consumed, so their capacity
+// is reused
+class PayloadPool
+{
+
+    public:
+
+        static constexpr std::size_t BUFFERS_MAX = 4096;
+        // Don't keep buffers of exceptionally large messages
+        static constexpr std::size_t BUFFER_CAPACITY_MAX = 1 << 20;
+
+        static void acquire(std::string& _Buffer)
+        {
+            if (!PayloadPool::get().try_dequeue(_Buffer)) _Buffer = std::string();
+        }
+
+        static void release(std::string&& _Buffer)
+        {
+            if (_Buffer.capacity() == 0 || _Buffer.capacity() > BUFFER_CAPACITY_MAX ||
+                PayloadPool::get().size_approx() >= BUFFERS_MAX) return;
+            _Buffer.clear();
+            PayloadPool::get().enqueue(std::move(_Buffer));
+        }
+
+    private:
+
+        static moodycamel::ConcurrentQueue<std::string>& get()
+        {
+            static moodycamel::ConcurrentQueue<std::string> Pool;
+            return Pool;
+        }
+};
+
 // JSON message
 struct NetworkMessage
 {
-    entt::entity ClientID;
+    entt::entity ClientID{entt::null};
     std::string Payload;
+
+    // Order of reception, parser workers might finish out of order
+    std::uint64_t Sequence{0};
+
+    // Received as binary frame, see binary_message.hpp
+    bool IsBinary{false};
+
+    // Time of reception, to measure the age of queued messages
+    std::chrono::steady_clock::time_point Timestamp{};
+};
+
+// JSON-RPC message to be sent, stamped when enqueued to measure the
+// latency until it is handed to the connection
+struct OutgoingMessage
+{
+    std::string Payload;
+    std::chrono::steady_clock::time_point Timestamp{};
+};
+
+// Queue of outgoing messages. The sender blocks on it and is idle without
+// any wakeups otherwise. Messages are sent right away or, if batching (see
+// NetworkManager::setBatching()), at the end of each tick, i.e. on flush(),
+// so that those enqueued in the same tick go out as one JSON-RPC batch
+class OutgoingQueue
+{
+
+    public:
+
+        bool enqueue(std::string _Payload)
+        {
+            Enqueued_.fetch_add(1, std::memory_order_relaxed);
+            return Queue_.enqueue({std::move(_Payload), std::chrono::steady_clock::now()});
+        }
+
+        // Blocks until a message was enqueued or flush()/wake() was
+        // called. A wakeup is returned as message without payload
+        void waitDequeue(OutgoingMessage& _Message)
+        {
+            Queue_.wait_dequeue(_Message);
+        }
+
+        // End of tick, send what was enqueued since the last flush. To be
+        // called by the producing thread once per frame. Without new
+        // messages, the sender isn't woken up
+        void flush()
+        {
+            if (Enqueued_.exchange(0, std::memory_order_relaxed) == 0) return;
+            Queue_.enqueue(OutgoingMessage());
+        }
+
+        // Wake the sender, e.g. on connection state changes or to quit
+        void wake()
+        {
+            Queue_.enqueue(OutgoingMessage());
+        }
+
+        // Including pending wakeups
+        std::size_t getSizeApprox() const {return Queue_.size_approx();}
+
+    private:
+
+        moodycamel::BlockingConcurrentQueue<OutgoingMessage> Queue_;
+        // Messages enqueued since the last flush
+        std::atomic<std::uint64_t> Enqueued_{0};
 };
 
+// Pooled storage to parse a message in-situ. Values are allocated from a
+// fixed arena, strings point into the payload buffer. Hence, parsing does
+// not allocate in steady state unless a message exceeds the arena
+struct DocumentBuffer
+{
+    static constexpr std::size_t ARENA_SIZE = 4096;
+    static constexpr std::size_t STACK_SIZE = 4096;
+
+    using AllocatorType = rapidjson::MemoryPoolAllocator<>;
+    using DocumentType = rapidjson::GenericDocument<rapidjson::UTF8<>, AllocatorType, AllocatorType>;
+
+    DocumentBuffer() :
+        Allocator(Arena, ARENA_SIZE),
+        StackAllocator(Stack, STACK_SIZE),
+        Document(&Allocator, STACK_SIZE/2, &StackAllocator) {}
+
+    DocumentBuffer(const DocumentBuffer&) = delete;
+    DocumentBuffer& operator=(const DocumentBuffer&) = delete;
+
+    // Arenas had to allocate additional chunks from the heap
+    bool hasOverflow() const
+    {
+        return Allocator.Capacity() > ARENA_SIZE || StackAllocator.Capacity() > STACK_SIZE;
+    }
+
+    // Rewind arenas, payload buffer keeps its capacity
+    void reset()
+    {
+        Document.SetNull();
+        Allocator.Clear();
+        StackAllocator.Clear();
+        Buffer.clear();
+    }
+
+    alignas(8) char Arena[ARENA_SIZE];
+    alignas(8) char Stack[STACK_SIZE];
+    AllocatorType Allocator;
+    AllocatorType StackAllocator;
+    DocumentType Document;
+    std::string Buffer;
+};
+
+// Returns document buffers to their pool instead of deleting them
+struct DocumentRecycler
+{
+    moodycamel::BlockingConcurrentQueue<DocumentBuffer*>* Pool{nullptr};
+
+    void operator()(DocumentBuffer* _Doc) const
+    {
+        _Doc->reset();
+        Pool->enqueue(_Doc);
+    }
+};
+
+using DocumentPtr = std::unique_ptr<DocumentBuffer, DocumentRecycler>;
+
 // JSON message parsed into rapidjson::Document
 struct NetworkDocument
 {
-    entt::entity ClientID;
-    std::shared_ptr<const rapidjson::Document> Payload;
+    entt::entity ClientID{entt::null};
+    DocumentPtr Payload;
+
+    // Copied from NetworkMessage, Payload is empty on parse errors
+    std::uint64_t Sequence{0};
+
+    // Hashed JSON-RPC method name, 0 if there is none (e.g. results)
+    entt::id_type Method{0};
+
+    // Entity of a state update. Only the latest full update per method and
+    // entity needs to be applied, deltas before it are superseded as well
+    std::uint32_t Eid{0};
+    bool IsCoalescible{false};
+    bool IsDelta{false};
+
+    // Binary messages are not parsed but passed on in order
+    std::string Binary;
+
+    // Copied from NetworkMessage
+    std::chrono::steady_clock::time_point Timestamp{};
 };
 
 #endif // NETWORK_MESSAGE_HPP
@@ -1,19 +1,48 @@
 #ifndef PERFORMANCE_TIMERS_HPP
 #define PERFORMANCE_TIMERS_HPP
 
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
 #include "avg_filter.hpp"
 #include "timer.hpp"
 
 struct PerformanceTimers
 {
+    static constexpr int PARSER_WORKERS_MAX{8};
+
+    Timer Motion;
     Timer Queue;
     Timer Render;
+    Timer Snapshot;
     Timer ViewportTest;
 
+    AvgFilter<double> MotionAvg{50};
     AvgFilter<double> QueueAvg{100};
+    AvgFilter<double> SnapshotAvg{50};
+
+    // Time budget per frame for processing the queue, the remaining
+    // backlog is deferred to the next frame
+    double QueueBudget{0.005};
+    std::size_t QueueDepth{0};
+    std::size_t QueueDeferred{0};
+    double QueueOldestAge{0.0};
+    // Updates skipped, since superseded by a later one of the same entity
+    std::uint64_t QueueCoalesced{0};
+    // Delta updates with a lost base
+    std::uint64_t QueueKeyframeRequests{0};
     AvgFilter<double> RenderAvg{50};
     AvgFilter<double> ViewportTestAvg{50};
 
+    // Written by parser worker threads, hence atomic averages
+    std::array<std::atomic<double>, PARSER_WORKERS_MAX> ParseAvg{};
+    std::atomic<int> ParseWorkers{0};
+    // Heap allocations of the parser stage, i.e. new pooled documents or
+    // messages exceeding a document's arena
+    std::atomic<std::uint64_t> ParseAllocations{0};
+
     AvgFilter<double> ServerPhysicsFrameTimeAvg{50};
     AvgFilter<double> ServerQueueInFrameTimeAvg{50};
     AvgFilter<double> ServerQueueOutFrameTimeAvg{50};
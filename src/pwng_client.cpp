@@ -10,26 +10,44 @@
 #include <argagg/argagg.hpp>
 #include <concurrentqueue/concurrentqueue.h>
 #include <entt/entity/registry.hpp>
-#include <rapidjson/document.h>
-#include <rapidjson/error/en.h>
 
+#include "clock_sync.hpp"
 #include "components.hpp"
+#include "galaxy_cache.hpp"
+#include "ingest_manager.hpp"
+#include "interest_system.hpp"
 #include "json_manager.hpp"
 #include "message_handler.hpp"
+#include "method_dispatcher.hpp"
+#include "motion_system.hpp"
 #include "name_system.hpp"
 #include "network_manager.hpp"
+#include "parser_manager.hpp"
 #include "pwng_client.hpp"
 #include "render_system.hpp"
+#include "request_tracker.hpp"
+#include "snapshot_system.hpp"
+#include "subscription_manager.hpp"
 #include "ui_manager.hpp"
 
 PwngClient::PwngClient(const Arguments& arguments): Platform::Application{arguments, NoCreate}
 
 {
+    Reg_.set<ClockSync>(Reg_);
+    Reg_.set<GalaxyCache>();
+    Reg_.set<IngestManager>(Reg_, Timers_, SimTime_);
+    Reg_.set<InterestSystem>(Reg_);
     Reg_.set<JsonManager>(Reg_);
     Reg_.set<MessageHandler>();
+    Reg_.set<MethodDispatcher>();
+    Reg_.set<MotionSystem>(Reg_, Timers_);
     Reg_.set<NameSystem>(Reg_);
     Reg_.set<NetworkManager>(Reg_);
+    Reg_.set<ParserManager>(Reg_, Timers_);
     Reg_.set<RenderSystem>(Reg_, Timers_);
+    Reg_.set<RequestTracker>(Reg_);
+    Reg_.set<SnapshotSystem>(Reg_, Timers_, SimTime_);
+    Reg_.set<SubscriptionManager>(Reg_);
     Reg_.set<UIManager>(Reg_, ImGUI_, &InputQueue_, &OutputQueue_);
 
     auto& Messages = Reg_.ctx<MessageHandler>();
@@ -44,8 +62,49 @@ PwngClient::PwngClient(const Arguments& arguments): Platform::Application{argume
     Messages.registerSource("gfx", "gfx");
     Messages.registerSource("ui", "ui");
 
+    argagg::parser ArgParser
+    {{
+        {"galaxy_cache", {"--galaxy-cache"}, "Galaxy cache file (default: galaxy.cache)", 1},
+        {"record", {"--record"}, "Record received messages to the given session log", 1},
+        {"replay", {"--replay"}, "Replay the given session log instead of connecting", 1},
+        {"replay_speed", {"--replay-speed"},
+         "Replay speed as factor of the recorded rate, 0 is as fast as possible (default: 1)", 1},
+        {"snapshot_memory", {"--snapshot-memory"}, "Memory of the snapshot history in MiB (default: 64)", 1},
+        {"snapshot_seconds", {"--snapshot-seconds"}, "Seconds of the snapshot history (default: 30)", 1}
+    }};
+
+    argagg::parser_results Args;
+    try
+    {
+        Args = ArgParser.parse(arguments.argc, arguments.argv);
+    }
+    catch (const std::exception& e)
+    {
+        Messages.report("prg", "Couldn't parse arguments: " + std::string(e.what()), MessageHandler::ERROR);
+    }
+
+    Reg_.ctx<SnapshotSystem>().configure(
+        Args["snapshot_seconds"].as<double>(SnapshotSystem::DURATION_DEFAULT),
+        static_cast<std::size_t>(Args["snapshot_memory"].as<double>(SnapshotSystem::MEMORY_DEFAULT) * 1024.0 * 1024.0));
+
+    auto& Cache = Reg_.ctx<GalaxyCache>();
+    Cache.setFile(Args["galaxy_cache"].as<std::string>("galaxy.cache"));
+    if (Cache.load())
+    {
+        Messages.report("prg", "Galaxy cache loaded (" + std::to_string(Cache.getStarCount()) + " stars)",
+                        MessageHandler::INFO);
+    }
+
     this->setupWindow();
+    this->setupIngest();
     this->setupNetwork();
+
+    auto& Network = Reg_.ctx<NetworkManager>();
+    if (Args["record"]) Network.startRecording(Args["record"].as<std::string>());
+    if (Args["replay"])
+    {
+        Network.startReplay(Args["replay"].as<std::string>(), Args["replay_speed"].as<double>(1.0));
+    }
     Reg_.ctx<RenderSystem>().setupCamera();
     Reg_.ctx<RenderSystem>().setupGraphics();
     setSwapInterval(1);
@@ -55,25 +114,54 @@ PwngClient::PwngClient(const Arguments& arguments): Platform::Application{argume
 
 void PwngClient::drawEvent()
 {
-    auto& Renderer = Reg_.ctx<RenderSystem>();
+    auto& Ingest = Reg_.ctx<IngestManager>();
     auto& Network = Reg_.ctx<NetworkManager>();
-    auto& UI = Reg_.ctx<UIManager>();
+    auto& Renderer = Reg_.ctx<RenderSystem>();
+
+    Network.processLog();
+    Network.processReconnect();
+
+    // A short loss of connection shouldn't reload everything, hence the
+    // scene is kept and subscriptions are resumed once reconnected
+    if (IsConnectionLostEventTriggered_)
+    {
+        Ingest.markStale();
+        IsConnectionLostEventTriggered_.store(false);
+    }
+    if (IsReconnectEventTriggered_)
+    {
+        Reg_.ctx<SubscriptionManager>().resume();
+        Ingest.resume();
+        Reg_.ctx<InterestSystem>().reset();
+        Reg_.ctx<ClockSync>().reset();
+        IsReconnectEventTriggered_.store(false);
+    }
 
-    this->getObjectsFromQueue();
+    Ingest.getObjectsFromQueue();
 
     if (IsDisconnectEventTriggered_)
     {
-        Renderer.cleanupScene();
-        Renderer.resetCamera();
-        UI.cleanupHooks();
-        this->cleanupScene();
+        Ingest.cleanupScene();
+        Reg_.ctx<SubscriptionManager>().clear();
+        Reg_.ctx<InterestSystem>().reset();
+        Reg_.ctx<ClockSync>().reset();
+        Reg_.ctx<SnapshotSystem>().reset();
 
         IsDisconnectEventTriggered_.store(false);
     }
+    // While paused, a recorded snapshot is shown instead
+    auto& Snapshots = Reg_.ctx<SnapshotSystem>();
+    if (!Snapshots.isPaused()) Reg_.ctx<MotionSystem>().process();
+    Snapshots.process();
     Renderer.renderScene();
     Renderer.renderScale();
+    Reg_.ctx<InterestSystem>().process();
 
     this->updateUI();
+    // Frame is about to be presented, measure staleness of its updates
+    Reg_.ctx<ClockSync>().process();
+    // End of tick, requests of this frame are sent if batching
+    OutputQueue_.flush();
     swapBuffers();
     redraw();
 }
@@ -176,216 +264,36 @@ void PwngClient::viewportEvent(ViewportEvent& Event)
     ImGUI_.relayout(Vector2(Event.windowSize()), Event.windowSize(), Event.framebufferSize());
 }
 
-void PwngClient::cleanupScene()
+void PwngClient::setupIngest()
 {
-    auto& Messages = Reg_.ctx<MessageHandler>();
-
-    Id2EntityMap_.clear();
-    auto v_1 = Reg_.view<NameComponent>();
-    auto v_2 = Reg_.view<TireComponent>();
-    Reg_.destroy(v_1.begin(), v_1.end());
-    Reg_.destroy(v_2.begin(), v_2.end());
-
-    DBLK(Messages.report("prg", "Registry size after disconnect (cleanup): " +
-                         std::to_string(Reg_.alive()) +
-                         " of " + std::to_string(Reg_.size()), MessageHandler::DEBUG_L1);)
-}
-
-void PwngClient::getObjectsFromQueue()
-{
-    Timers_.Queue.start();
-    auto& Messages = Reg_.ctx<MessageHandler>();
-    auto& Names = Reg_.ctx<NameSystem>();
+    auto& Ingest = Reg_.ctx<IngestManager>();
     auto& Renderer = Reg_.ctx<RenderSystem>();
     auto& UI = Reg_.ctx<UIManager>();
 
-    bool NewHooks = false;
-    std::string Data;
-    while (InputQueue_.try_dequeue(Data))
+    Ingest.init(&OutputQueue_);
+    Ingest.addListenerCleanup([&Renderer, &UI]()
     {
-        rapidjson::Document j;
-        rapidjson::ParseResult r = j.Parse(Data.c_str());
-
-        if (!r)
-        {
-            // std::cerr << "JSON parse error: %s (%u)", rapidjson::GetParseError_En(r.Code()), r.Offset();
-            Messages.report("prg", "Parse error: "+std::string(rapidjson::GetParseError_En(r.Code())), MessageHandler::ERROR);
-            continue;
-        }
-
-        rapidjson::Value::ConstMemberIterator it = j.FindMember("method");
-        if (it != j.MemberEnd())
-        {
-            if (j["method"] == "galaxy_data_stars")
-            {
-
-                std::string n = j["params"]["name"].GetString();
-                double      m = j["params"]["m"].GetDouble();
-                double      x = j["params"]["spx"].GetDouble();
-                double      y = j["params"]["spy"].GetDouble();
-                double      r = j["params"]["r"].GetDouble();
-                int        SC = j["params"]["sc"].GetInt();
-                double      t = j["params"]["t"].GetDouble();
-
-                entt::id_type Id = j["params"]["eid"].GetUint();
-
-                auto ci = Id2EntityMap_.find(Id);
-                if (ci != Id2EntityMap_.end())
-                {
-                    Reg_.emplace_or_replace<RadiusComponent>(ci->second, r);
-                    Reg_.emplace_or_replace<MassComponent>(ci->second, m);
-                    Reg_.emplace_or_replace<SystemPositionComponent>(ci->second, x, y);
-                    Reg_.emplace_or_replace<StarDataComponent>(ci->second, SpectralClassE(SC), t);
-                    Reg_.emplace_or_replace<NameComponent>(ci->second);
-                    Names.setName(ci->second, n);
-                    // DBLK(Messages.report("prg", "Entity components updated", MessageHandler::DEBUG_L3);)
-                }
-                else
-                {
-                    auto e = Reg_.create();
-                    Reg_.emplace<RadiusComponent>(e, r);
-                    Reg_.emplace<MassComponent>(e, m);
-                    Reg_.emplace<SystemPositionComponent>(e, x, y);
-                    Reg_.emplace<StarDataComponent>(e, SpectralClassE(SC), t);
-                    Reg_.emplace<NameComponent>(e);
-                    Names.setName(e, n);
-                    UI.addCamHook(e, n);
-                    Id2EntityMap_[Id] = e;
-                    // DBLK(Messages.report("prg", "Entity created", MessageHandler::DEBUG_L2);)
-                }
-            }
-            else if (j["method"] == "galaxy_data_systems")
-            {
-                std::string n = j["params"]["name"].GetString();
-                entt::id_type Id = j["params"]["eid"].GetUint();
-
-                auto ci = Id2EntityMap_.find(Id);
-                if (ci != Id2EntityMap_.end())
-                {
-                    Reg_.emplace_or_replace<StarSystemTag>(ci->second);
-                    Reg_.emplace_or_replace<NameComponent>(ci->second);
-                    Names.setName(ci->second, n);
-                    // DBLK(Messages.report("prg", "Entity components updated", MessageHandler::DEBUG_L3);)
-                }
-                else
-                {
-                    auto e = Reg_.create();
-                    Reg_.emplace<StarSystemTag>(e);
-                    Reg_.emplace<NameComponent>(e);
-                    Names.setName(e, n);
-                    UI.addSystem(e, n);
-                    Id2EntityMap_[Id] = e;
-                    // DBLK(Messages.report("prg", "Entity created", MessageHandler::DEBUG_L2);)
-                }
-            }
-            else if (j["method"] == "bc_dynamic_data")
-            {
-                std::string n = j["params"]["name"].GetString();
-                double      m = j["params"]["m"].GetDouble();
-                double    spx = j["params"]["spx"].GetDouble();
-                double    spy = j["params"]["spy"].GetDouble();
-                double     px = j["params"]["px"].GetDouble();
-                double     py = j["params"]["py"].GetDouble();
-                double      r = j["params"]["r"].GetDouble();
-
-                entt::id_type Id = j["params"]["eid"].GetUint();
-
-                auto ci = Id2EntityMap_.find(Id);
-                if (ci != Id2EntityMap_.end())
-                {
-                    Reg_.emplace_or_replace<MassComponent>(ci->second, m);
-                    Reg_.emplace_or_replace<PositionComponent>(ci->second, px, py);
-                    Reg_.emplace_or_replace<RadiusComponent>(ci->second, r);
-                    Reg_.emplace_or_replace<SystemPositionComponent>(ci->second, spx, spy);
-                    Reg_.emplace_or_replace<NameComponent>(ci->second);
-                    Names.setName(ci->second, n);
-                    // DBLK(Messages.report("prg", "Entity components updated", MessageHandler::DEBUG_L3);)
-                }
-                else
-                {
-                    auto e = Reg_.create();
-                    Reg_.emplace<MassComponent>(e, m);
-                    Reg_.emplace<PositionComponent>(e, px, py);
-                    Reg_.emplace<RadiusComponent>(e, r);
-                    Reg_.emplace<SystemPositionComponent>(e, spx, spy);
-                    Reg_.emplace<NameComponent>(e);
-                    Names.setName(e, n);
-                    UI.addCamHook(e, n);
-                    NewHooks = true;
-                    Id2EntityMap_[Id] = e;
-                    // DBLK(Messages.report("prg", "Entity created", MessageHandler::DEBUG_L2);)
-                }
-            }
-            else if (j["method"] == "perf_stats")
-            {
-                Timers_.ServerPhysicsFrameTimeAvg.addValue(j["params"]["t_phy"].GetDouble());
-                Timers_.ServerQueueInFrameTimeAvg.addValue(j["params"]["t_queue_in"].GetDouble());
-                Timers_.ServerQueueOutFrameTimeAvg.addValue(j["params"]["t_queue_out"].GetDouble());
-                Timers_.ServerSimFrameTimeAvg.addValue(j["params"]["t_sim"].GetDouble());
-            }
-            else if (j["method"] == "sim_stats")
-            {
-                SimTime_.fromStamp(j["params"]["ts"].GetString());
-                SimTime_.setAcceleration(j["params"]["ts_f"].GetDouble());
-            }
-            else if (j["method"] == "tire_data")
-            {
-                double RimX = j["params"]["rim_xy"][0].GetDouble();
-                double RimY = j["params"]["rim_xy"][1].GetDouble();
-                double RimR = j["params"]["rim_r"].GetDouble();
-
-                entt::id_type Id = j["params"]["eid"].GetUint();
-
-                auto ci = Id2EntityMap_.find(Id);
-                if (ci != Id2EntityMap_.end())
-                {
-                    Reg_.emplace_or_replace<PositionComponent>(ci->second, RimX, RimY);
-
-                    auto& Tire = Reg_.emplace_or_replace<TireComponent>(ci->second, RimR);
-                    for (auto i=0u; i<TireComponent::SEGMENTS; ++i)
-                    {
-                        Tire.RubberX[i] = j["params"]["rubber"][i*2].GetDouble();
-                        Tire.RubberY[i] = j["params"]["rubber"][i*2+1].GetDouble();
-                    }
-                }
-                else
-                {
-                    auto e = Reg_.create();
-                    auto& Tire = Reg_.emplace<TireComponent>(e, RimX, RimY, RimR);
-
-                    Reg_.emplace<SystemPositionComponent>(e, 0.0, 0.0);
-                    Reg_.emplace<PositionComponent>(e, RimX, RimY);
-
-                    for (auto i=0u; i<TireComponent::SEGMENTS; ++i)
-                    {
-                        Tire.RubberX[i] = j["params"]["rubber"][i*2].GetDouble();
-                        Tire.RubberY[i] = j["params"]["rubber"][i*2+1].GetDouble();
-                    }
-                    UI.addCamHook(e, "Tire");
-                    NewHooks = true;
-                    Id2EntityMap_[Id] = e;
-                }
-            }
-        }
-        it = j.FindMember("result");
-        if (it != j.MemberEnd())
-        {
-            if (j["result"] == "success")
-            {
-                NewHooks = true;
-                UI.finishSystemsTransfer();
-                DBLK(Messages.report("prg", "Receiving systems successful", MessageHandler::DEBUG_L1);)
-                Renderer.buildGalaxyMesh();
-            }
-        }
-        if (NewHooks)
-        {
-            UI.finishSystemsTransfer();
-            NewHooks = false;
-        }
-    }
-    Timers_.Queue.stop();
-    Timers_.QueueAvg.addValue(Timers_.Queue.elapsed());
+        Renderer.cleanupScene();
+        Renderer.resetCamera();
+        UI.cleanupHooks();
+    });
+    Ingest.addListenerNewObject([&UI](entt::entity _e, const std::string& _n){UI.addCamHook(_e, _n);});
+    Ingest.addListenerNewSystem([&UI](entt::entity _e, const std::string& _n){UI.addSystem(_e, _n);});
+    Ingest.addListenerNewHooks([&UI](){UI.finishSystemsTransfer();});
+    Ingest.addListenerRemovedObject([&Renderer, &UI](entt::entity _e)
+    {
+        Renderer.releaseHook(_e);
+        UI.removeCamHook(_e);
+    });
+    Ingest.addListenerGalaxyCached([&Renderer](const float* _v, std::size_t _n){Renderer.buildGalaxyMesh(_v, _n);});
+    Ingest.addListenerGalaxyReceived([&Ingest, &Renderer]()
+    {
+        // Vertices are shared by the mesh and the cache
+        std::vector<float> Vertices;
+        Renderer.getGalaxyVertices(Vertices);
+        Renderer.buildGalaxyMesh(Vertices.data(), Vertices.size());
+        Ingest.writeGalaxyCache(Vertices);
+    });
 }
 
 void PwngClient::setupNetwork()
@@ -394,7 +302,13 @@ void PwngClient::setupNetwork()
     auto& Network = Reg_.ctx<NetworkManager>();
 
     Network.init(&InputQueue_, &OutputQueue_);
+    Reg_.ctx<ParserManager>().init(&InputQueue_);
+    Reg_.ctx<SubscriptionManager>().init(&OutputQueue_);
+    Reg_.ctx<InterestSystem>().init(&OutputQueue_);
+    Reg_.ctx<ClockSync>().init(&OutputQueue_);
+    Network.addListenerConnectionLost([this](){IsConnectionLostEventTriggered_.store(true);});
     Network.addListenerDisconnect([this](){IsDisconnectEventTriggered_.store(true);});
+    Network.addListenerReconnect([this](){IsReconnectEventTriggered_.store(true);});
 }
 
 void PwngClient::setupWindow()
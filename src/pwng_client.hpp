@@ -2,12 +2,14 @@
 #define PWNG_CLIENT_HPP
 
 #include <string>
-#include <unordered_map>
+#include <vector>
 
 #include <entt/entity/entity.hpp>
 #include <Magnum/Platform/Sdl2Application.h>
 
 #include "color_palette.hpp"
+#include "components.hpp"
+#include "network_message.hpp"
 #include "performance_timers.hpp"
 #include "scale_unit.hpp"
 #include "sim_timer.hpp"
@@ -24,8 +26,8 @@ class PwngClient : public Magnum::Platform::Application
     private:
 
         entt::registry Reg_;
-        moodycamel::ConcurrentQueue<std::string> InputQueue_;
-        moodycamel::ConcurrentQueue<std::string> OutputQueue_;
+        moodycamel::BlockingConcurrentQueue<NetworkMessage> InputQueue_;
+        OutgoingQueue OutputQueue_;
 
         //--- Window Event Handling ---//
         void drawEvent() override;
@@ -38,8 +40,7 @@ class PwngClient : public Magnum::Platform::Application
         void textInputEvent(TextInputEvent& Event) override;
         void viewportEvent(ViewportEvent& Event) override;
 
-        void cleanupScene();
-        void getObjectsFromQueue();
+        void setupIngest();
         void setupNetwork();
         void setupWindow();
         void updateUI();
@@ -47,12 +48,9 @@ class PwngClient : public Magnum::Platform::Application
         PerformanceTimers Timers_;
         SimTimer SimTime_;
 
-        bool IsGalaxyTransmitted_{false};
-
+        std::atomic_bool IsConnectionLostEventTriggered_{false};
         std::atomic_bool IsDisconnectEventTriggered_{false};
-
-        //--- Graphics ---//
-        std::unordered_map<std::uint32_t, entt::entity> Id2EntityMap_;
+        std::atomic_bool IsReconnectEventTriggered_{false};
 
         //--- UI ---//
         Magnum::ImGuiIntegration::Context ImGUI_{Magnum::NoCreate};
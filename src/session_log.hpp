@@ -0,0 +1,103 @@
+#ifndef SESSION_LOG_HPP
+#define SESSION_LOG_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+// Compact log of received websocket frames, for replaying server sessions
+// without a network connection.
+//
+// Layout (host byte order):
+//   Header  : Magic (char[8], "PWNGLOG1")
+//   Records : Time (u64, ns since start of recording), IsBinary (u8),
+//             Length (u32), Payload (Length bytes)
+
+constexpr char SESSION_LOG_MAGIC[8] = {'P', 'W', 'N', 'G', 'L', 'O', 'G', '1'};
+
+class SessionLogWriter
+{
+
+    public:
+
+        bool open(const std::string& _File)
+        {
+            File_.open(_File, std::ios::binary | std::ios::trunc);
+            if (!File_) return false;
+            File_.write(SESSION_LOG_MAGIC, sizeof(SESSION_LOG_MAGIC));
+            return bool(File_);
+        }
+
+        void close() {File_.close();}
+
+        bool isOpen() const {return File_.is_open();}
+
+        bool write(std::uint64_t _Time, bool _IsBinary, const std::string& _Payload)
+        {
+            const std::uint8_t IsBinary = _IsBinary;
+            const std::uint32_t Length = _Payload.size();
+            File_.write(reinterpret_cast<const char*>(&_Time), sizeof(_Time));
+            File_.write(reinterpret_cast<const char*>(&IsBinary), sizeof(IsBinary));
+            File_.write(reinterpret_cast<const char*>(&Length), sizeof(Length));
+            File_.write(_Payload.data(), Length);
+            return bool(File_);
+        }
+
+    private:
+
+        std::ofstream File_;
+};
+
+class SessionLogReader
+{
+
+    public:
+
+        // Longer records are considered corrupt instead of being allocated
+        static constexpr std::uint32_t LENGTH_MAX = 64u << 20;
+
+        bool open(const std::string& _File)
+        {
+            File_.open(_File, std::ios::binary | std::ios::ate);
+            Size_ = File_ ? static_cast<std::uint64_t>(File_.tellg()) : 0u;
+            File_.seekg(0);
+            char Magic[sizeof(SESSION_LOG_MAGIC)]{};
+            File_.read(Magic, sizeof(Magic));
+            return File_ && std::memcmp(Magic, SESSION_LOG_MAGIC, sizeof(Magic)) == 0;
+        }
+
+        // Reads into the given buffer, reusing its capacity. Returns false at
+        // the end of the log, if the last record is truncated or if a record
+        // is corrupt, see isCorrupt()
+        bool read(std::uint64_t& _Time, bool& _IsBinary, std::string& _Payload)
+        {
+            std::uint8_t IsBinary{0};
+            std::uint32_t Length{0};
+            File_.read(reinterpret_cast<char*>(&_Time), sizeof(_Time));
+            File_.read(reinterpret_cast<char*>(&IsBinary), sizeof(IsBinary));
+            File_.read(reinterpret_cast<char*>(&Length), sizeof(Length));
+            if (!File_) return false;
+            const auto Left = Size_ - static_cast<std::uint64_t>(File_.tellg());
+            if (Length > LENGTH_MAX || Length > Left)
+            {
+                IsCorrupt_ = true;
+                return false;
+            }
+            _IsBinary = IsBinary;
+            _Payload.resize(Length);
+            File_.read(&_Payload[0], Length);
+            return bool(File_);
+        }
+
+        // Record length exceeds LENGTH_MAX or the rest of the file
+        bool isCorrupt() const {return IsCorrupt_;}
+
+    private:
+
+        std::ifstream File_;
+        std::uint64_t Size_{0};
+        bool IsCorrupt_{false};
+};
+
+#endif // SESSION_LOG_HPP
@@ -0,0 +1,146 @@
+#ifndef SNAPSHOT_RING_HPP
+#define SNAPSHOT_RING_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <entt/entity/registry.hpp>
+
+// Bounded history of object positions. Snapshots are kept in a ring of
+// fixed capacity, their records (entity and position) as structure of
+// arrays in a second ring shared by all snapshots. Records of a snapshot
+// are consecutive modulo the record capacity. If either ring is full, the
+// oldest snapshot is dropped, thus memory is allocated once on reserve.
+// A snapshot exceeding the record capacity on its own is truncated.
+class SnapshotRing
+{
+
+    public:
+
+        struct Snapshot
+        {
+            // Simulation time, see SimTimer
+            std::uint32_t Years{0u};
+            double Seconds{0.0};
+            // Client time of recording, see ClockSync::getClientTime()
+            double ClientTime{0.0};
+            std::size_t First{0};
+            std::size_t Count{0};
+        };
+
+        // Drops all snapshots
+        void reserve(std::size_t _Snapshots, std::size_t _Records)
+        {
+            Snapshots_.assign(_Snapshots, Snapshot());
+            Entities_.assign(_Records, entt::null);
+            X_.assign(_Records, 0.0);
+            Y_.assign(_Records, 0.0);
+            this->clear();
+        }
+
+        void clear()
+        {
+            SnapshotFirst_ = 0;
+            SnapshotCount_ = 0;
+            RecordFirst_ = 0;
+            RecordCount_ = 0;
+        }
+
+        // Start a new snapshot, records are added to the newest one
+        void begin(std::uint32_t _Years, double _Seconds, double _ClientTime)
+        {
+            if (Snapshots_.empty() || Entities_.empty()) return;
+            if (SnapshotCount_ == Snapshots_.size()) this->dropOldest();
+
+            auto& s = Snapshots_[(SnapshotFirst_ + SnapshotCount_) % Snapshots_.size()];
+            s.Years = _Years;
+            s.Seconds = _Seconds;
+            s.ClientTime = _ClientTime;
+            s.First = (RecordFirst_ + RecordCount_) % Entities_.size();
+            s.Count = 0;
+            ++SnapshotCount_;
+        }
+
+        void add(entt::entity _e, double _x, double _y)
+        {
+            if (SnapshotCount_ == 0 || Entities_.empty()) return;
+            while (RecordCount_ == Entities_.size())
+            {
+                // Newest snapshot would overwrite itself
+                if (SnapshotCount_ == 1)
+                {
+                    ++Truncated_;
+                    return;
+                }
+                this->dropOldest();
+            }
+            const auto i = (RecordFirst_ + RecordCount_) % Entities_.size();
+            Entities_[i] = _e;
+            X_[i] = _x;
+            Y_[i] = _y;
+            ++RecordCount_;
+            ++Snapshots_[(SnapshotFirst_ + SnapshotCount_ - 1) % Snapshots_.size()].Count;
+        }
+
+        void dropOldest()
+        {
+            if (SnapshotCount_ == 0) return;
+            const auto& s = Snapshots_[SnapshotFirst_];
+            RecordFirst_ = (RecordFirst_ + s.Count) % Entities_.size();
+            RecordCount_ -= s.Count;
+            SnapshotFirst_ = (SnapshotFirst_ + 1) % Snapshots_.size();
+            --SnapshotCount_;
+        }
+
+        // Snapshot _i, the oldest being 0
+        const Snapshot& operator[](std::size_t _i) const
+        {
+            return Snapshots_[(SnapshotFirst_ + _i) % Snapshots_.size()];
+        }
+
+        // Calls _f(entt::entity, double x, double y) for all records of
+        // snapshot _i
+        template<class Func>
+        void forEach(std::size_t _i, Func _f) const
+        {
+            const auto& s = (*this)[_i];
+            std::size_t r = s.First;
+            for (auto j=0u; j<s.Count; ++j)
+            {
+                _f(Entities_[r], X_[r], Y_[r]);
+                if (++r == Entities_.size()) r = 0;
+            }
+        }
+
+        bool empty() const {return SnapshotCount_ == 0;}
+        std::size_t size() const {return SnapshotCount_;}
+        std::size_t getCapacity() const {return Snapshots_.size();}
+        std::size_t getRecords() const {return RecordCount_;}
+        std::size_t getRecordCapacity() const {return Entities_.size();}
+        // Records not stored since a single snapshot exceeded the capacity
+        std::uint64_t getTruncated() const {return Truncated_;}
+        std::size_t getMemory() const
+        {
+            return Snapshots_.size() * sizeof(Snapshot) + Entities_.size() * RECORD_SIZE;
+        }
+
+        static constexpr std::size_t RECORD_SIZE = sizeof(entt::entity) + 2 * sizeof(double);
+
+    private:
+
+        std::vector<Snapshot> Snapshots_;
+        std::size_t SnapshotFirst_{0};
+        std::size_t SnapshotCount_{0};
+
+        // Records, structure of arrays
+        std::vector<entt::entity> Entities_;
+        std::vector<double> X_;
+        std::vector<double> Y_;
+        std::size_t RecordFirst_{0};
+        std::size_t RecordCount_{0};
+
+        std::uint64_t Truncated_{0};
+};
+
+#endif // SNAPSHOT_RING_HPP
@@ -0,0 +1,911 @@
+// Local stand-in for pwng-server. It speaks the JSON-RPC notifications
+// handled by the client (galaxy, dynamic objects, tires and statistics) at a
+// configurable scale and rate, either as JSON-RPC or in the binary wire
+// format, so that the client can be load tested without a real server.
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <argagg/argagg.hpp>
+#include <entt/entity/registry.hpp>
+#include <rapidjson/document.h>
+
+#define ASIO_STANDALONE
+#include <websocketpp/config/asio_no_tls.hpp>
+#include <websocketpp/server.hpp>
+
+#include "binary_message.hpp"
+#include "dynamic_update.hpp"
+#include "json_manager.hpp"
+#include "message_handler.hpp"
+#include "timer.hpp"
+
+class StandinServer
+{
+
+    public:
+
+        typedef websocketpp::server<websocketpp::config::asio> ServerType;
+
+        struct Config
+        {
+            std::uint32_t Stars{100000};
+            std::uint32_t Systems{1000};
+            std::uint32_t Objects{1000};
+            std::uint32_t Tires{0};
+            double Rate{30.0};
+            std::uint32_t KeyframeInterval{30};
+            std::uint32_t Seed{1};
+        };
+
+        explicit StandinServer(entt::registry& _Reg) : Reg_(_Reg) {}
+
+        bool init(std::uint16_t _Port);
+        void run(const Config& _Config);
+
+    private:
+
+        struct Subscriber
+        {
+            bool IsBinary{false};
+            bool IsDynamicData{false};
+
+            // Intervals of statistics in seconds, 0 if not subscribed
+            double PerfStatsInterval{0.0};
+            double PerfStatsNext{0.0};
+            double SimStatsInterval{0.0};
+            double SimStatsNext{0.0};
+
+            // Galaxy transfer requested by sub_galaxy_data_evt
+            bool IsGalaxyRequested{false};
+            std::uint32_t GalaxyBatchSize{0};
+            std::string GalaxyCacheHash;
+            JsonManager::RequestIDType GalaxyRequestID{0};
+
+            // Region of dynamic objects sent, set by cmd_interest_region.
+            // Everything is sent without region
+            bool IsInterestRegion{false};
+            double InterestXMin{0.0};
+            double InterestXMax{0.0};
+            double InterestYMin{0.0};
+            double InterestYMax{0.0};
+
+            // Requests to be answered by the run thread
+            std::vector<JsonManager::RequestIDType> Acks;
+            std::vector<JsonManager::RequestIDType> UnknownRequests;
+            // Pings and their simulation time of reception
+            std::vector<std::pair<JsonManager::RequestIDType, double>> Pings;
+
+            bool isInterested(double _x, double _y) const
+            {
+                return !IsInterestRegion ||
+                       (_x >= InterestXMin && _x <= InterestXMax &&
+                        _y >= InterestYMin && _y <= InterestYMax);
+            }
+        };
+
+        void broadcastDynamicData(double _t, std::uint32_t _Seq, bool _IsDelta);
+        void broadcastStats(double _t, double _FrameTime);
+        void generateGalaxy();
+        void handleRequest(const rapidjson::Value& _j, Subscriber& _Sub);
+        void onClose(websocketpp::connection_hdl _Connection);
+        void onMessage(websocketpp::connection_hdl _Connection, ServerType::message_ptr _Msg);
+        void onOpen(websocketpp::connection_hdl _Connection);
+        void respond();
+        bool send(websocketpp::connection_hdl _Connection, const std::string& _Msg,
+                  websocketpp::frame::opcode::value _Op = websocketpp::frame::opcode::text);
+        void sendGalaxy(websocketpp::connection_hdl _Connection, const Subscriber& _Sub);
+
+        // Simulation time, runs in real time since start
+        double getSimTime() const
+        {
+            return std::chrono::duration<double>(std::chrono::steady_clock::now() - Start_).count();
+        }
+
+        static double parseInterval(const std::string& _Method);
+
+        entt::registry& Reg_;
+
+        Config Config_;
+
+        const std::chrono::steady_clock::time_point Start_{std::chrono::steady_clock::now()};
+
+        ServerType Server_;
+        std::thread ThreadServer_;
+
+        std::mutex SubscribersMutex_;
+        std::map<websocketpp::connection_hdl, Subscriber,
+                 std::owner_less<websocketpp::connection_hdl>> Subscribers_;
+
+        // Set by cmd_request_keyframe, next update is sent as keyframe
+        std::atomic<bool> IsKeyframeRequested_{false};
+
+        // Static galaxy, generated once from the seed
+        struct
+        {
+            std::vector<double> x;
+            std::vector<double> y;
+            std::vector<double> Masses;
+            std::vector<double> Radii;
+            std::vector<std::int32_t> SpectralClasses;
+            std::vector<double> Temperatures;
+        } Galaxy_;
+        std::string GalaxyHash_;
+
+        // Positions of dynamic objects of the current tick
+        std::vector<double> ObjectsX_;
+        std::vector<double> ObjectsY_;
+
+        std::string BufferBinary_;
+        std::string BufferInterest_;
+        std::string BufferTires_;
+        std::vector<std::string> BufferJson_;
+};
+
+bool StandinServer::init(std::uint16_t _Port)
+{
+    auto& Messages = Reg_.ctx<MessageHandler>();
+
+    Server_.clear_access_channels(websocketpp::log::alevel::all);
+    Server_.set_close_handler(std::bind(&StandinServer::onClose, this,
+                              std::placeholders::_1));
+    Server_.set_message_handler(std::bind(&StandinServer::onMessage, this,
+                                std::placeholders::_1, std::placeholders::_2));
+    Server_.set_open_handler(std::bind(&StandinServer::onOpen, this,
+                             std::placeholders::_1));
+    try
+    {
+        Server_.init_asio();
+        Server_.set_reuse_addr(true);
+        Server_.listen(_Port);
+        Server_.start_accept();
+    }
+    catch (const websocketpp::exception& e)
+    {
+        Messages.report("srv", "Couldn't start server: " + std::string(e.what()), MessageHandler::ERROR);
+        return false;
+    }
+    ThreadServer_ = std::thread(std::bind(&ServerType::run, &Server_));
+
+    Messages.report("srv", "Listening on port " + std::to_string(_Port), MessageHandler::INFO);
+    return true;
+}
+
+void StandinServer::run(const Config& _Config)
+{
+    Config_ = _Config;
+    this->generateGalaxy();
+
+    const auto Step = std::chrono::duration<double>(1.0 / Config_.Rate);
+    auto Next = std::chrono::steady_clock::now();
+    double t{0.0};
+    std::uint32_t Seq{0};
+    Timer FrameTimer;
+
+    while (true)
+    {
+        FrameTimer.start();
+
+        // Galaxy transfers are sent from this thread as well, since the
+        // JSON manager is not thread safe
+        std::vector<std::pair<websocketpp::connection_hdl, Subscriber>> GalaxyRequests;
+        {
+            std::lock_guard<std::mutex> Lock(SubscribersMutex_);
+            for (auto& Sub : Subscribers_)
+            {
+                if (Sub.second.IsGalaxyRequested)
+                {
+                    GalaxyRequests.push_back(Sub);
+                    Sub.second.IsGalaxyRequested = false;
+                }
+            }
+        }
+        for (const auto& Request : GalaxyRequests) this->sendGalaxy(Request.first, Request.second);
+        this->respond();
+
+        // Without keyframe interval, full updates are sent like older servers
+        // do. Objects are updated every tick, hence the tick is the sequence
+        bool IsDelta = Config_.KeyframeInterval > 0 && Seq % Config_.KeyframeInterval != 0;
+        if (IsKeyframeRequested_.exchange(false)) IsDelta = false;
+        this->broadcastDynamicData(t, Seq++, IsDelta);
+
+        FrameTimer.stop();
+        this->broadcastStats(t, FrameTimer.elapsed());
+
+        t += Step.count();
+        Next += std::chrono::duration_cast<std::chrono::steady_clock::duration>(Step);
+        std::this_thread::sleep_until(Next);
+    }
+}
+
+void StandinServer::broadcastDynamicData(double _t, std::uint32_t _Seq, bool _IsDelta)
+{
+    auto& Json = Reg_.ctx<JsonManager>();
+
+    // Dynamic objects and tires follow the galaxy's ids
+    const std::uint32_t ObjectIdFirst = Config_.Stars + Config_.Systems;
+    const std::uint32_t TireIdFirst = ObjectIdFirst + Config_.Objects;
+
+    // Objects on circular orbits with varying radius and angular velocity
+    ObjectsX_.resize(Config_.Objects);
+    ObjectsY_.resize(Config_.Objects);
+    for (auto i=0u; i<Config_.Objects; ++i)
+    {
+        const double r = 1.0e9 * (1.0 + i % 100);
+        const double w = 1.0e-2 / (1.0 + i % 7);
+        ObjectsX_[i] = r * std::cos(w * _t + i);
+        ObjectsY_[i] = r * std::sin(w * _t + i);
+    }
+
+    // Tires rolling along x with a wobbling rubber, positions are absolute
+    std::array<double, 2*BINARY_TIRE_SEGMENTS> Rubber;
+    auto Tire = [_t, &Rubber](std::uint32_t _i, double& _x, double& _y, double& _r)
+    {
+        _r = 0.3;
+        _x = 2.0 * _i + std::fmod(_t, 100.0);
+        _y = _r;
+        for (auto j=0; j<BINARY_TIRE_SEGMENTS; ++j)
+        {
+            const double a = 2.0*M_PI * j / BINARY_TIRE_SEGMENTS - _t/_r;
+            const double d = _r + 0.1 + 0.01 * std::sin(8.0*a + 5.0*_t);
+            Rubber[2*j] = _x + d * std::cos(a);
+            Rubber[2*j+1] = _y + d * std::sin(a);
+        }
+    };
+
+    const bool IsSequenced = Config_.KeyframeInterval > 0;
+    // Emission time, for the client to measure staleness
+    const double Time = this->getSimTime();
+
+    // Objects of the interest region of a subscriber, all without region
+    auto encodeBinary = [&](std::string& _Buffer, const Subscriber& _Sub)
+    {
+        std::uint32_t Count{0};
+        for (auto i=0u; i<Config_.Objects; ++i)
+        {
+            if (_Sub.isInterested(ObjectsX_[i], ObjectsY_[i])) ++Count;
+        }
+        _Buffer.clear();
+        BinaryWriter Writer(_Buffer);
+        Writer.writeHeader(IsSequenced ? BinaryMessageE::DYNAMIC_DELTA :
+                                         BinaryMessageE::DYNAMIC_DATA, Count, Time);
+        for (auto i=0u; i<Config_.Objects; ++i)
+        {
+            const double x = ObjectsX_[i];
+            const double y = ObjectsY_[i];
+            if (!_Sub.isInterested(x, y)) continue;
+            Writer.write(std::uint32_t(ObjectIdFirst + i));
+            if (IsSequenced)
+            {
+                Writer.write(_Seq);
+                if (_IsDelta)
+                {
+                    // Only positions change on orbits
+                    Writer.write(DynamicUpdate::FIELD_POSITION);
+                    Writer.write(x);
+                    Writer.write(y);
+                    continue;
+                }
+                Writer.write(std::uint8_t(DynamicUpdate::FIELDS_ALL | DynamicUpdate::FIELD_KEYFRAME));
+            }
+            Writer.write(1.0e20);   // m
+            Writer.write(1.0e6);    // r
+            Writer.write(0.0);      // spx
+            Writer.write(0.0);      // spy
+            Writer.write(x);        // px
+            Writer.write(y);        // py
+            Writer.writeName(("Object_" + std::to_string(i)).c_str());
+        }
+    };
+
+    // Encode both formats at most once per tick, independent of the
+    // number of subscribers. Binary messages of subscribers with interest
+    // region are encoded for each of them
+    bool IsBinaryEncoded{false};
+    bool IsJsonEncoded{false};
+    bool IsTiresEncoded{false};
+
+    std::lock_guard<std::mutex> Lock(SubscribersMutex_);
+    for (auto& Sub : Subscribers_)
+    {
+        if (!Sub.second.IsDynamicData) continue;
+
+        if (Sub.second.IsBinary)
+        {
+            std::string* Buffer = &BufferBinary_;
+            if (Sub.second.IsInterestRegion)
+            {
+                encodeBinary(BufferInterest_, Sub.second);
+                Buffer = &BufferInterest_;
+            }
+            else if (!IsBinaryEncoded)
+            {
+                encodeBinary(BufferBinary_, Sub.second);
+                IsBinaryEncoded = true;
+            }
+            if (Config_.Tires > 0 && !IsTiresEncoded)
+            {
+                BufferTires_.clear();
+                BinaryWriter WriterTires(BufferTires_);
+                WriterTires.writeHeader(BinaryMessageE::TIRE_DATA, Config_.Tires, Time);
+                for (auto i=0u; i<Config_.Tires; ++i)
+                {
+                    double x, y, r;
+                    Tire(i, x, y, r);
+                    WriterTires.write(std::uint32_t(TireIdFirst + i));
+                    WriterTires.write(x);
+                    WriterTires.write(y);
+                    WriterTires.write(r);
+                    for (auto v : Rubber) WriterTires.write(v);
+                }
+                IsTiresEncoded = true;
+            }
+            if (!this->send(Sub.first, *Buffer, websocketpp::frame::opcode::binary)) continue;
+            if (Config_.Tires > 0)
+            {
+                this->send(Sub.first, BufferTires_, websocketpp::frame::opcode::binary);
+            }
+        }
+        else
+        {
+            if (!IsJsonEncoded)
+            {
+                BufferJson_.resize(Config_.Objects + Config_.Tires);
+                for (auto i=0u; i<Config_.Objects; ++i)
+                {
+                    const double x = ObjectsX_[i];
+                    const double y = ObjectsY_[i];
+                    if (_IsDelta)
+                    {
+                        Json.createNotification("bc_dynamic_data")
+                            .addParam("eid", std::uint32_t(ObjectIdFirst + i))
+                            .addParam("seq", _Seq)
+                            .addParam("px", x)
+                            .addParam("py", y)
+                            .addParam("t", Time)
+                            .finalise();
+                        BufferJson_[i] = Json.getString();
+                        continue;
+                    }
+                    Json.createNotification("bc_dynamic_data")
+                        .addParam("eid", std::uint32_t(ObjectIdFirst + i))
+                        .addParam("name", "Object_" + std::to_string(i))
+                        .addParam("m", 1.0e20)
+                        .addParam("r", 1.0e6)
+                        .addParam("spx", 0.0)
+                        .addParam("spy", 0.0)
+                        .addParam("px", x)
+                        .addParam("py", y)
+                        .addParam("t", Time);
+                    if (IsSequenced)
+                    {
+                        Json.addParam("seq", _Seq)
+                            .addParam("kf", true);
+                    }
+                    Json.finalise();
+                    BufferJson_[i] = Json.getString();
+                }
+                for (auto i=0u; i<Config_.Tires; ++i)
+                {
+                    double x, y, r;
+                    Tire(i, x, y, r);
+                    Json.createNotification("tire_data")
+                        .addParam("eid", std::uint32_t(TireIdFirst + i))
+                        .addParam("rim_r", r)
+                        .addParam("t", Time)
+                        .beginArray("rim_xy")
+                            .addValue(x)
+                            .addValue(y)
+                        .endArray()
+                        .beginArray("rubber");
+                    for (auto v : Rubber) Json.addValue(v);
+                    Json.endArray()
+                        .finalise();
+                    BufferJson_[Config_.Objects + i] = Json.getString();
+                }
+                IsJsonEncoded = true;
+            }
+            // One message per object, hence simply skip those not of interest
+            for (auto i=0u; i<BufferJson_.size(); ++i)
+            {
+                if (i < Config_.Objects && !Sub.second.isInterested(ObjectsX_[i], ObjectsY_[i])) continue;
+                if (!this->send(Sub.first, BufferJson_[i])) break;
+            }
+        }
+    }
+}
+
+void StandinServer::broadcastStats(double _t, double _FrameTime)
+{
+    auto& Json = Reg_.ctx<JsonManager>();
+
+    std::lock_guard<std::mutex> Lock(SubscribersMutex_);
+    for (auto& Sub : Subscribers_)
+    {
+        auto& s = Sub.second;
+        if (s.PerfStatsInterval > 0.0 && _t >= s.PerfStatsNext)
+        {
+            // The stand-in has no physics, report the time of a tick as
+            // simulation time
+            Json.createNotification("perf_stats")
+                .addParam("t_phy", 0.0)
+                .addParam("t_queue_in", 0.0)
+                .addParam("t_queue_out", _FrameTime)
+                .addParam("t_sim", _FrameTime)
+                .finalise();
+            this->send(Sub.first, Json.getString());
+            s.PerfStatsNext = _t + s.PerfStatsInterval;
+        }
+        if (s.SimStatsInterval > 0.0 && _t >= s.SimStatsNext)
+        {
+            constexpr double S_PER_Y = 365.0*24.0*60.0*60.0;
+            const double Time = this->getSimTime();
+            const auto Years = std::uint32_t(Time / S_PER_Y);
+            Json.createNotification("sim_stats")
+                .addParam("ts", std::to_string(Years) + ":" + std::to_string(Time - Years*S_PER_Y))
+                .addParam("ts_f", 1.0)
+                .finalise();
+            this->send(Sub.first, Json.getString());
+            s.SimStatsNext = _t + s.SimStatsInterval;
+        }
+    }
+}
+
+void StandinServer::generateGalaxy()
+{
+    auto& Messages = Reg_.ctx<MessageHandler>();
+
+    // Two armed logarithmic spiral with an exponential disk, roughly the
+    // size of the milky way
+    constexpr double LY = 9.46e15;
+    constexpr double DISK_SCALE = 1.0e4 * LY;
+    constexpr double RADIUS_MAX = 5.0e4 * LY;
+    constexpr double PITCH = 0.22;
+
+    // Shares of spectral classes M, K, G, F, A, B, O and their temperature
+    // range, mass and radius (in solar units)
+    constexpr double SOLAR_MASS = 1.989e30;
+    constexpr double SOLAR_RADIUS = 6.957e8;
+    const std::array<double, 7> Shares{0.7645, 0.121, 0.076, 0.03, 0.006, 0.0013, 0.0002};
+    const std::array<double, 8> Temperatures{2400.0, 3700.0, 5200.0, 6000.0, 7500.0, 10000.0, 30000.0, 40000.0};
+    const std::array<double, 7> Masses{0.3, 0.7, 1.0, 1.3, 2.0, 8.0, 30.0};
+    const std::array<double, 7> Radii{0.4, 0.8, 1.0, 1.3, 1.8, 5.0, 10.0};
+
+    std::mt19937 Gen(Config_.Seed);
+    std::exponential_distribution<double> DistDisk(1.0);
+    std::normal_distribution<double> DistScatter(0.0, 0.25);
+    std::uniform_real_distribution<double> DistUniform(0.0, 1.0);
+    std::discrete_distribution<std::int32_t> DistClass(Shares.begin(), Shares.end());
+
+    const auto n = Config_.Stars;
+    Galaxy_.x.resize(n);
+    Galaxy_.y.resize(n);
+    Galaxy_.Masses.resize(n);
+    Galaxy_.Radii.resize(n);
+    Galaxy_.SpectralClasses.resize(n);
+    Galaxy_.Temperatures.resize(n);
+    for (auto i=0u; i<n; ++i)
+    {
+        const double r = std::min(DistDisk(Gen) * DISK_SCALE, RADIUS_MAX) + 1.0e3 * LY;
+        const double a = std::log(r / (1.0e3 * LY)) / std::tan(PITCH) + (i % 2) * M_PI + DistScatter(Gen);
+        Galaxy_.x[i] = r * std::cos(a);
+        Galaxy_.y[i] = r * std::sin(a);
+
+        const auto c = DistClass(Gen);
+        const double f = DistUniform(Gen);
+        Galaxy_.SpectralClasses[i] = c;
+        Galaxy_.Temperatures[i] = Temperatures[c] + f * (Temperatures[c+1] - Temperatures[c]);
+        Galaxy_.Masses[i] = Masses[c] * (0.8 + 0.4 * f) * SOLAR_MASS;
+        Galaxy_.Radii[i] = Radii[c] * (0.8 + 0.4 * f) * SOLAR_RADIUS;
+    }
+
+    // The galaxy is fully determined by its parameters
+    GalaxyHash_ = "standin-" + std::to_string(Config_.Seed) + "-" + std::to_string(Config_.Stars) +
+                  "-" + std::to_string(Config_.Systems);
+
+    Messages.report("srv", "Generated galaxy of " + std::to_string(n) + " stars", MessageHandler::INFO);
+}
+
+void StandinServer::onClose(websocketpp::connection_hdl _Connection)
+{
+    std::lock_guard<std::mutex> Lock(SubscribersMutex_);
+    Subscribers_.erase(_Connection);
+    Reg_.ctx<MessageHandler>().report("srv", "Client disconnected", MessageHandler::INFO);
+}
+
+void StandinServer::handleRequest(const rapidjson::Value& _j, Subscriber& _Sub)
+{
+    auto& Messages = Reg_.ctx<MessageHandler>();
+
+    if (!_j.IsObject() || !_j.HasMember("method") || !_j["method"].IsString())
+    {
+        Messages.report("srv", "Invalid request", MessageHandler::WARNING);
+        return;
+    }
+    std::string Method = _j["method"].GetString();
+
+    static const rapidjson::Value NoParams(rapidjson::kObjectType);
+    const auto& Params = (_j.HasMember("params") && _j["params"].IsObject()) ? _j["params"] : NoParams;
+
+    const JsonManager::RequestIDType Id = (_j.HasMember("id") && _j["id"].IsUint()) ? _j["id"].GetUint() : 0;
+    bool IsKnown{true};
+
+    if (Method == "cmd_wire_format" && Params.HasMember("format"))
+    {
+        _Sub.IsBinary = (Params["format"] == "binary");
+    }
+    else if (Method == "sub_galaxy_data_evt")
+    {
+        _Sub.IsGalaxyRequested = true;
+        _Sub.GalaxyBatchSize = Params.HasMember("batch_size") ? Params["batch_size"].GetUint() : 0;
+        _Sub.GalaxyCacheHash = Params.HasMember("cache_hash") ? Params["cache_hash"].GetString() : "";
+        _Sub.GalaxyRequestID = Id;
+        // Answered once the galaxy was sent
+        return;
+    }
+    else if (Method == "sub_dynamic_data_evt")
+    {
+        _Sub.IsDynamicData = true;
+    }
+    else if (Method == "unsub_dynamic_data_evt")
+    {
+        _Sub.IsDynamicData = false;
+    }
+    else if (Method.rfind("sub_perf_stats_", 0) == 0)
+    {
+        _Sub.PerfStatsInterval = parseInterval(Method);
+        _Sub.PerfStatsNext = 0.0;
+    }
+    else if (Method.rfind("unsub_perf_stats", 0) == 0)
+    {
+        _Sub.PerfStatsInterval = 0.0;
+    }
+    else if (Method.rfind("sub_sim_stats_", 0) == 0)
+    {
+        _Sub.SimStatsInterval = parseInterval(Method);
+        _Sub.SimStatsNext = 0.0;
+    }
+    else if (Method.rfind("unsub_sim_stats", 0) == 0)
+    {
+        _Sub.SimStatsInterval = 0.0;
+    }
+    else if (Method == "cmd_interest_region")
+    {
+        if (Params.HasMember("x_min") && Params.HasMember("x_max") &&
+            Params.HasMember("y_min") && Params.HasMember("y_max"))
+        {
+            _Sub.IsInterestRegion = true;
+            _Sub.InterestXMin = Params["x_min"].GetDouble();
+            _Sub.InterestXMax = Params["x_max"].GetDouble();
+            _Sub.InterestYMin = Params["y_min"].GetDouble();
+            _Sub.InterestYMax = Params["y_max"].GetDouble();
+            // Objects entering the region are unknown to the client
+            IsKeyframeRequested_.store(true);
+        }
+        else
+        {
+            _Sub.IsInterestRegion = false;
+        }
+    }
+    else if (Method == "cmd_ping")
+    {
+        // Answered by the run thread, which stamps the time of sending
+        if (Id != 0) _Sub.Pings.emplace_back(Id, this->getSimTime());
+        return;
+    }
+    else if (Method == "cmd_request_keyframe")
+    {
+        // All objects share the same sequence, so simply send a full keyframe
+        IsKeyframeRequested_.store(true);
+    }
+    else
+    {
+        DBLK(Messages.report("srv", "Ignoring request " + Method, MessageHandler::DEBUG_L1);)
+        IsKnown = false;
+    }
+    // Notifications are not answered
+    if (Id == 0) return;
+    if (IsKnown) _Sub.Acks.push_back(Id);
+    else _Sub.UnknownRequests.push_back(Id);
+}
+
+void StandinServer::onMessage(websocketpp::connection_hdl _Connection, ServerType::message_ptr _Msg)
+{
+    auto& Messages = Reg_.ctx<MessageHandler>();
+
+    rapidjson::Document j;
+    if (j.Parse(_Msg->get_payload().c_str()).HasParseError() || (j.IsArray() && j.Empty()))
+    {
+        Messages.report("srv", "Invalid request", MessageHandler::WARNING);
+        return;
+    }
+
+    std::lock_guard<std::mutex> Lock(SubscribersMutex_);
+    auto& Sub = Subscribers_[_Connection];
+    // JSON-RPC batch
+    if (j.IsArray())
+    {
+        for (const auto& Request : j.GetArray()) this->handleRequest(Request, Sub);
+    }
+    else
+    {
+        this->handleRequest(j, Sub);
+    }
+}
+
+void StandinServer::onOpen(websocketpp::connection_hdl _Connection)
+{
+    std::lock_guard<std::mutex> Lock(SubscribersMutex_);
+    Subscribers_[_Connection] = Subscriber{};
+    Reg_.ctx<MessageHandler>().report("srv", "Client connected", MessageHandler::INFO);
+}
+
+void StandinServer::respond()
+{
+    auto& Json = Reg_.ctx<JsonManager>();
+
+    std::lock_guard<std::mutex> Lock(SubscribersMutex_);
+    for (auto& Sub : Subscribers_)
+    {
+        auto& s = Sub.second;
+        if (s.Acks.empty() && s.UnknownRequests.empty() && s.Pings.empty()) continue;
+
+        std::vector<std::string> Responses;
+        for (auto Id : s.Acks)
+        {
+            Json.createResult("success").finalise(Id);
+            Responses.push_back(Json.getString());
+        }
+        for (auto Id : s.UnknownRequests)
+        {
+            Json.createError(JsonManager::ErrorType::METHOD).finalise(Id);
+            Responses.push_back(Json.getString());
+        }
+        for (const auto& Ping : s.Pings)
+        {
+            Json.createResult()
+                .beginObject()
+                    .addNamedValue("t1", Ping.second)
+                    .addNamedValue("t2", this->getSimTime())
+                    .addNamedValue("ts_f", 1.0)
+                .endObject()
+                .finalise(Ping.first);
+            Responses.push_back(Json.getString());
+        }
+
+        // Responses of a tick are sent as JSON-RPC batch
+        if (Responses.size() == 1)
+        {
+            this->send(Sub.first, Responses.front());
+        }
+        else
+        {
+            std::string Batch{"["};
+            for (const auto& Response : Responses)
+            {
+                if (Batch.size() > 1) Batch += ",";
+                Batch += Response;
+            }
+            Batch += "]";
+            this->send(Sub.first, Batch);
+        }
+
+        s.Acks.clear();
+        s.UnknownRequests.clear();
+        s.Pings.clear();
+    }
+}
+
+bool StandinServer::send(websocketpp::connection_hdl _Connection, const std::string& _Msg,
+                         websocketpp::frame::opcode::value _Op)
+{
+    websocketpp::lib::error_code ErrorCode;
+    Server_.send(_Connection, _Msg, _Op, ErrorCode);
+    if (ErrorCode)
+    {
+        Reg_.ctx<MessageHandler>().report("srv", "Sending failed: " + ErrorCode.message());
+        return false;
+    }
+    return true;
+}
+
+void StandinServer::sendGalaxy(websocketpp::connection_hdl _Connection, const Subscriber& _Sub)
+{
+    auto& Json = Reg_.ctx<JsonManager>();
+    auto& Messages = Reg_.ctx<MessageHandler>();
+
+    Json.createNotification("galaxy_info")
+        .addParam("hash", GalaxyHash_)
+        .addParam("stars", Config_.Stars)
+        .addParam("systems", Config_.Systems)
+        .finalise();
+    if (!this->send(_Connection, Json.getString())) return;
+
+    Timer TransferTimer;
+    const bool IsCached = (_Sub.GalaxyCacheHash == GalaxyHash_);
+    if (!IsCached)
+    {
+        const auto n = Config_.Stars;
+        const auto BatchSize = std::max(_Sub.GalaxyBatchSize, 1u);
+        const auto StarName = [](std::uint32_t _i) {return "Star_" + std::to_string(_i);};
+
+        for (auto First=0u; First<n; First+=BatchSize)
+        {
+            const auto Last = std::min(First+BatchSize, n);
+            if (_Sub.IsBinary)
+            {
+                std::string Buffer;
+                BinaryWriter Writer(Buffer);
+                Writer.writeHeader(BinaryMessageE::GALAXY_STARS, Last-First);
+                for (auto i=First; i<Last; ++i)
+                {
+                    Writer.write(std::uint32_t(i));
+                    Writer.write(Galaxy_.SpectralClasses[i]);
+                    Writer.write(Galaxy_.Masses[i]);
+                    Writer.write(Galaxy_.Radii[i]);
+                    Writer.write(Galaxy_.x[i]);
+                    Writer.write(Galaxy_.y[i]);
+                    Writer.write(Galaxy_.Temperatures[i]);
+                    Writer.writeName(StarName(i).c_str());
+                }
+                if (!this->send(_Connection, Buffer, websocketpp::frame::opcode::binary)) return;
+            }
+            else if (_Sub.GalaxyBatchSize > 0)
+            {
+                Json.createNotification("galaxy_data_stars_batch")
+                    .addParam("count", std::uint32_t(Last-First));
+                Json.beginArray("eid");
+                for (auto i=First; i<Last; ++i) Json.addValue(std::uint32_t(i));
+                Json.endArray().beginArray("name");
+                for (auto i=First; i<Last; ++i) Json.addValue(StarName(i).c_str());
+                Json.endArray().beginArray("m");
+                for (auto i=First; i<Last; ++i) Json.addValue(Galaxy_.Masses[i]);
+                Json.endArray().beginArray("r");
+                for (auto i=First; i<Last; ++i) Json.addValue(Galaxy_.Radii[i]);
+                Json.endArray().beginArray("spx");
+                for (auto i=First; i<Last; ++i) Json.addValue(Galaxy_.x[i]);
+                Json.endArray().beginArray("spy");
+                for (auto i=First; i<Last; ++i) Json.addValue(Galaxy_.y[i]);
+                Json.endArray().beginArray("sc");
+                for (auto i=First; i<Last; ++i) Json.addValue(int(Galaxy_.SpectralClasses[i]));
+                Json.endArray().beginArray("t");
+                for (auto i=First; i<Last; ++i) Json.addValue(Galaxy_.Temperatures[i]);
+                Json.endArray().finalise();
+                if (!this->send(_Connection, Json.getString())) return;
+            }
+            else
+            {
+                for (auto i=First; i<Last; ++i)
+                {
+                    Json.createNotification("galaxy_data_stars")
+                        .addParam("eid", std::uint32_t(i))
+                        .addParam("name", StarName(i))
+                        .addParam("m", Galaxy_.Masses[i])
+                        .addParam("r", Galaxy_.Radii[i])
+                        .addParam("spx", Galaxy_.x[i])
+                        .addParam("spy", Galaxy_.y[i])
+                        .addParam("sc", std::uint32_t(Galaxy_.SpectralClasses[i]))
+                        .addParam("t", Galaxy_.Temperatures[i])
+                        .finalise();
+                    if (!this->send(_Connection, Json.getString())) return;
+                }
+            }
+        }
+
+        // Star systems follow the stars' ids
+        if (_Sub.IsBinary && Config_.Systems > 0)
+        {
+            std::string Buffer;
+            BinaryWriter Writer(Buffer);
+            Writer.writeHeader(BinaryMessageE::GALAXY_SYSTEMS, Config_.Systems);
+            for (auto i=0u; i<Config_.Systems; ++i)
+            {
+                Writer.write(std::uint32_t(n + i));
+                Writer.writeName(("System_" + std::to_string(i)).c_str());
+            }
+            if (!this->send(_Connection, Buffer, websocketpp::frame::opcode::binary)) return;
+        }
+        else
+        {
+            for (auto i=0u; i<Config_.Systems; ++i)
+            {
+                Json.createNotification("galaxy_data_systems")
+                    .addParam("eid", std::uint32_t(n + i))
+                    .addParam("name", "System_" + std::to_string(i))
+                    .finalise();
+                if (!this->send(_Connection, Json.getString())) return;
+            }
+        }
+    }
+
+    Json.createResult("success").finalise(_Sub.GalaxyRequestID);
+    this->send(_Connection, Json.getString());
+
+    TransferTimer.stop();
+    Messages.report("srv", IsCached ? "Galaxy cached by client, nothing sent" :
+                    "Galaxy sent in " + std::to_string(TransferTimer.elapsed()) + " s", MessageHandler::INFO);
+}
+
+double StandinServer::parseInterval(const std::string& _Method)
+{
+    // Suffixes as offered by the client, _evt is sent every tick
+    static const std::map<std::string, double> Intervals
+    {
+        {"_s01", 0.1}, {"_s05", 0.5}, {"_s1", 1.0}, {"_s5", 5.0}, {"_s10", 10.0}
+    };
+    const auto p = _Method.rfind('_');
+    if (p != std::string::npos)
+    {
+        auto it = Intervals.find(_Method.substr(p));
+        if (it != Intervals.end()) return it->second;
+    }
+    return std::numeric_limits<double>::min();
+}
+
+int main(int argc, char* argv[])
+{
+    entt::registry Reg;
+    Reg.set<JsonManager>(Reg);
+    auto& Messages = Reg.set<MessageHandler>();
+    Messages.setLevel(MessageHandler::INFO);
+    Messages.registerSource("jsn", "jsn");
+    Messages.registerSource("srv", "srv");
+
+    argagg::parser ArgParser
+    {{
+        {"help", {"-h", "--help"}, "Show this help message", 0},
+        {"keyframes", {"-k", "--keyframes"}, "Keyframe interval in updates, 0 sends full updates only (default: 30)", 1},
+        {"objects", {"-n", "--objects"}, "Number of dynamic objects (default: 1000)", 1},
+        {"port", {"-p", "--port"}, "Port to listen on (default: 9002)", 1},
+        {"rate", {"-r", "--rate"}, "Dynamic data update rate in Hz (default: 30)", 1},
+        {"seed", {"--seed"}, "Seed of the generated galaxy (default: 1)", 1},
+        {"stars", {"-s", "--stars"}, "Number of stars in the galaxy (default: 100000)", 1},
+        {"systems", {"-y", "--systems"}, "Number of star systems (default: 1000)", 1},
+        {"tires", {"-t", "--tires"}, "Number of tires (default: 0)", 1}
+    }};
+
+    argagg::parser_results Args;
+    try
+    {
+        Args = ArgParser.parse(argc, argv);
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    if (Args["help"])
+    {
+        std::cout << "pwng-standin-server: local stand-in for pwng-server" << std::endl
+                  << ArgParser;
+        return EXIT_SUCCESS;
+    }
+
+    StandinServer::Config Config;
+    Config.Stars = Args["stars"].as<std::uint32_t>(Config.Stars);
+    Config.Systems = Args["systems"].as<std::uint32_t>(Config.Systems);
+    Config.Objects = Args["objects"].as<std::uint32_t>(Config.Objects);
+    Config.Tires = Args["tires"].as<std::uint32_t>(Config.Tires);
+    Config.Rate = Args["rate"].as<double>(Config.Rate);
+    Config.KeyframeInterval = Args["keyframes"].as<std::uint32_t>(Config.KeyframeInterval);
+    Config.Seed = Args["seed"].as<std::uint32_t>(Config.Seed);
+
+    StandinServer Server(Reg);
+    if (!Server.init(Args["port"].as<std::uint16_t>(9002))) return EXIT_FAILURE;
+    Server.run(Config);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,112 @@
+#include "interest_system.hpp"
+
+#include <cmath>
+
+#include "components.hpp"
+#include "json_manager.hpp"
+#include "message_handler.hpp"
+#include "network_manager.hpp"
+#include "render_system.hpp"
+#include "request_tracker.hpp"
+
+void InterestSystem::process()
+{
+    if (!IsEnabled_ || !IsSupported_) return;
+    if (!Reg_.ctx<NetworkManager>().isConnected()) return;
+
+    const auto Now = std::chrono::steady_clock::now();
+    if (Now < Next_) return;
+
+    auto& Renderer = Reg_.ctx<RenderSystem>();
+    const auto Camera = Renderer.getCamera();
+    const auto Hook = Reg_.get<HookComponent>(Camera).e;
+
+    // Viewport in world coordinates, see RenderSystem::testViewportGalaxy
+    const auto& HookPosSys = Reg_.get<SystemPositionComponent>(Hook);
+    const auto* HookPos = Reg_.try_get<PositionComponent>(Hook);
+    const auto& CamPosSys = Reg_.get<SystemPositionComponent>(Camera);
+    const auto& CamPos = Reg_.get<PositionComponent>(Camera);
+    const auto& Zoom = Reg_.get<ZoomComponent>(Camera);
+
+    double x = HookPosSys.x - CamPosSys.x - CamPos.x;
+    double y = HookPosSys.y - CamPosSys.y - CamPos.y;
+    if (HookPos != nullptr)
+    {
+        x += HookPos->x;
+        y += HookPos->y;
+    }
+    const double hx = 0.5 * Renderer.getWindowSizeX() / Zoom.z;
+    const double hy = 0.5 * Renderer.getWindowSizeY() / Zoom.z;
+
+    if (IsRegionSent_)
+    {
+        // Padding of the region when it was sent
+        const double PadX = HalfX_ * (1.0 - 1.0/REGION_SCALE);
+        const double PadY = HalfY_ * (1.0 - 1.0/REGION_SCALE);
+        const bool IsInside = std::abs(x - CenterX_) + hx <= HalfX_ - HYSTERESIS * PadX &&
+                              std::abs(y - CenterY_) + hy <= HalfY_ - HYSTERESIS * PadY;
+        const bool IsTooLarge = hx * REGION_SCALE * HYSTERESIS_ZOOM < HalfX_;
+        if (IsInside && !IsTooLarge) return;
+    }
+
+    CenterX_ = x;
+    CenterY_ = y;
+    HalfX_ = hx * REGION_SCALE;
+    HalfY_ = hy * REGION_SCALE;
+    this->send();
+    Next_ = Now + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                      std::chrono::duration<double>(UPDATE_PERIOD));
+}
+
+void InterestSystem::reset()
+{
+    IsRegionSent_ = false;
+    IsSupported_ = true;
+    Next_ = {};
+}
+
+void InterestSystem::setEnabled(bool _IsEnabled)
+{
+    if (_IsEnabled == IsEnabled_) return;
+    IsEnabled_ = _IsEnabled;
+    if (!IsRegionSent_) return;
+    IsRegionSent_ = false;
+
+    // Request without region to receive all objects again
+    auto& Json = Reg_.ctx<JsonManager>();
+    const auto Id = Json.createRequest("cmd_interest_region")
+        .finalise();
+    OutputQueue_->enqueue(Json.getString());
+    Reg_.ctx<RequestTracker>().track(Id, "cmd_interest_region");
+}
+
+void InterestSystem::send()
+{
+    auto& Json = Reg_.ctx<JsonManager>();
+
+    const auto Id = Json.createRequest("cmd_interest_region")
+        .addParam("x_min", CenterX_ - HalfX_)
+        .addParam("x_max", CenterX_ + HalfX_)
+        .addParam("y_min", CenterY_ - HalfY_)
+        .addParam("y_max", CenterY_ + HalfY_)
+        .finalise();
+    OutputQueue_->enqueue(Json.getString());
+    IsRegionSent_ = true;
+    ++Updates_;
+
+    // Servers not knowing the method keep sending all objects
+    auto& Tracker = Reg_.ctx<RequestTracker>();
+    Tracker.track(Id, "cmd_interest_region");
+    Tracker.onResponse(Id,
+        [this](RequestTracker::StatusE _Status, const rapidjson::Value& _Error)
+        {
+            if (_Status != RequestTracker::StatusE::ERROR || !IsSupported_ || !_Error.IsObject()) return;
+            auto Code = _Error.FindMember("code");
+            if (Code != _Error.MemberEnd() && Code->value == -32601)
+            {
+                IsSupported_ = false;
+                Reg_.ctx<MessageHandler>().report("net", "Server doesn't support interest regions, "
+                                                  "receiving all objects", MessageHandler::INFO);
+            }
+        });
+}
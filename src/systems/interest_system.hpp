@@ -0,0 +1,68 @@
+#ifndef INTEREST_SYSTEM_HPP
+#define INTEREST_SYSTEM_HPP
+
+#include <chrono>
+#include <cstdint>
+
+#include <entt/entity/registry.hpp>
+
+#include "network_message.hpp"
+
+// Sends the region of interest around the camera (cmd_interest_region), so
+// that the server only sends dynamic objects in or near the viewport. The
+// region is larger than the viewport and only updated if the viewport gets
+// close to its border or if it became much larger than the viewport, i.e.
+// with hysteresis, so that panning and zooming don't flood the server.
+class InterestSystem
+{
+
+    public:
+
+        // Size of the region relative to the viewport
+        static constexpr double REGION_SCALE = 2.0;
+        // Update if the viewport entered this fraction of the padding...
+        static constexpr double HYSTERESIS = 0.5;
+        // ...or the region exceeds the viewport by this factor after zooming in
+        static constexpr double HYSTERESIS_ZOOM = 2.0;
+        // Minimum time between updates in seconds
+        static constexpr double UPDATE_PERIOD = 0.2;
+
+        explicit InterestSystem(entt::registry& _Reg) : Reg_(_Reg) {}
+
+        void init(OutgoingQueue* const _OutputQueue) {OutputQueue_ = _OutputQueue;}
+
+        // Test the camera and send the region if needed, once per frame
+        void process();
+        // Server doesn't know the region, e.g. new session or reconnected
+        void reset();
+        // Without region, the server sends all objects
+        void setEnabled(bool _IsEnabled);
+
+        bool isEnabled() const {return IsEnabled_;}
+        bool isSupported() const {return IsSupported_;}
+        std::uint64_t getUpdates() const {return Updates_;}
+
+    private:
+
+        void send();
+
+        entt::registry& Reg_;
+
+        OutgoingQueue* OutputQueue_{nullptr};
+
+        bool IsEnabled_{true};
+        // Cleared if the server doesn't know the method
+        bool IsSupported_{true};
+        bool IsRegionSent_{false};
+
+        // Region last sent, center and half size in metres
+        double CenterX_{0.0};
+        double CenterY_{0.0};
+        double HalfX_{0.0};
+        double HalfY_{0.0};
+
+        std::chrono::steady_clock::time_point Next_{};
+        std::uint64_t Updates_{0};
+};
+
+#endif // INTEREST_SYSTEM_HPP
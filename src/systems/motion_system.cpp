@@ -0,0 +1,76 @@
+#include "motion_system.hpp"
+
+#include <algorithm>
+
+#include "clock_sync.hpp"
+#include "components.hpp"
+
+void MotionSystem::process()
+{
+    if (!IsEnabled_) return;
+
+    Timers_.Motion.start();
+
+    const double t = ClockSync::getClientTime() - Delay_;
+
+    double IntervalSum{0.0};
+    std::size_t IntervalCount{0};
+    Extrapolated_ = 0;
+
+    Reg_.view<MotionComponent, PositionComponent>().each(
+        [&](const auto& _m, auto& _p)
+        {
+            const double dt = _m.t1 - _m.t0;
+            if (dt <= 0.0)
+            {
+                _p.x = _m.x1;
+                _p.y = _m.y1;
+                return;
+            }
+            IntervalSum += dt;
+            ++IntervalCount;
+
+            if (t <= _m.t0)
+            {
+                _p.x = _m.x0;
+                _p.y = _m.y0;
+            }
+            else if (t <= _m.t1)
+            {
+                const double f = (t - _m.t0) / dt;
+                _p.x = _m.x0 + f * (_m.x1 - _m.x0);
+                _p.y = _m.y0 + f * (_m.y1 - _m.y0);
+            }
+            else
+            {
+                const double f = 1.0 + std::min({t - _m.t1, EXTRAPOLATION_MAX, dt}) / dt;
+                _p.x = _m.x0 + f * (_m.x1 - _m.x0);
+                _p.y = _m.y0 + f * (_m.y1 - _m.y0);
+                ++Extrapolated_;
+            }
+        });
+
+    // Follow the update interval slowly, render time must not jump
+    if (IntervalCount > 0)
+    {
+        const double Target = std::min(DELAY_INTERVALS * IntervalSum / IntervalCount, DELAY_MAX);
+        Delay_ += 0.05 * (Target - Delay_);
+    }
+
+    Timers_.Motion.stop();
+    Timers_.MotionAvg.addValue(Timers_.Motion.elapsed());
+}
+
+void MotionSystem::setEnabled(bool _IsEnabled)
+{
+    IsEnabled_ = _IsEnabled;
+    if (IsEnabled_) return;
+
+    Reg_.view<MotionComponent, PositionComponent>().each(
+        [](const auto& _m, auto& _p)
+        {
+            _p.x = _m.x1;
+            _p.y = _m.y1;
+        });
+    Extrapolated_ = 0;
+}
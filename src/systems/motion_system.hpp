@@ -0,0 +1,52 @@
+#ifndef MOTION_SYSTEM_HPP
+#define MOTION_SYSTEM_HPP
+
+#include <cstddef>
+
+#include <entt/entity/registry.hpp>
+
+#include "performance_timers.hpp"
+
+// Moves dynamic objects smoothly between server updates. The rendered
+// position is interpolated between the last two positions received (see
+// MotionComponent) at a render time slightly behind the newest update, and
+// extrapolated for a short time if the next update is late. Thus, the
+// server's update rate can be lower than the frame rate.
+class MotionSystem
+{
+
+    public:
+
+        // Render time trails the newest updates by this many update
+        // intervals, so that there are two positions to interpolate in
+        // between despite jitter
+        static constexpr double DELAY_INTERVALS = 1.5;
+        static constexpr double DELAY_MAX = 0.5;
+        // Extrapolate at most this long beyond the last update and at most
+        // one update interval, hold afterwards
+        static constexpr double EXTRAPOLATION_MAX = 0.25;
+
+        explicit MotionSystem(entt::registry& _Reg, PerformanceTimers& _Timers) :
+            Reg_(_Reg), Timers_(_Timers) {}
+
+        // Update rendered positions, once per frame after ingesting updates
+        void process();
+        // Without interpolation, the latest position received is rendered
+        void setEnabled(bool _IsEnabled);
+
+        bool isEnabled() const {return IsEnabled_;}
+        double getDelay() const {return Delay_;}
+        // Objects extrapolated in the last frame, i.e. with late updates
+        std::size_t getExtrapolated() const {return Extrapolated_;}
+
+    private:
+
+        entt::registry& Reg_;
+        PerformanceTimers& Timers_;
+
+        bool IsEnabled_{true};
+        double Delay_{0.0};
+        std::size_t Extrapolated_{0};
+};
+
+#endif // MOTION_SYSTEM_HPP
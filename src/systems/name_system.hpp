@@ -28,6 +28,14 @@ class NameSystem
 
         }
 
+        // Copy name without temporary string, truncated if too long
+        static void copyName(NameComponent& _CompName, const char* _Name, std::size_t _Length)
+        {
+            if (_Length > NAME_SIZE_MAX-1) _Length = NAME_SIZE_MAX-1;
+            std::memcpy(_CompName.Name, _Name, _Length);
+            _CompName.Name[_Length] = '\0';
+        }
+
     private:
 
         entt::registry& Reg_;
@@ -21,29 +21,40 @@ RenderSystem::RenderSystem(entt::registry& _Reg, PerformanceTimers& _Timers) :
 {}
 
 void RenderSystem::buildGalaxyMesh()
+{
+    std::vector<float> Vertices;
+    this->getGalaxyVertices(Vertices);
+    this->buildGalaxyMesh(Vertices.data(), Vertices.size());
+}
+
+void RenderSystem::buildGalaxyMesh(const float* const _Vertices, const std::size_t _Size)
 {
     GL::Buffer Buffer{};
 
     MeshGalaxy_ = GL::Mesh{};
-    std::vector<float> Pos;
+
+    Buffer.setData(Containers::arrayView(_Vertices, _Size), GL::BufferUsage::StaticDraw);
+    MeshGalaxy_.setCount(_Size/6)
+               .setPrimitive(GL::MeshPrimitive::Points)
+               .addVertexBuffer(std::move(Buffer), 0, Shaders::VertexColor2D::Position{}, Shaders::VertexColor2D::Color4{});
+
+    IsGalaxySetup_ = true;
+}
+
+void RenderSystem::getGalaxyVertices(std::vector<float>& _Vertices)
+{
+    _Vertices.clear();
 
     Reg_.view<SystemPositionComponent, RadiusComponent, StarDataComponent>().each(
         [&](auto _e, const auto& _p, const auto& _r, const auto& _s)
     {
-        Pos.push_back(_p.x);
-        Pos.push_back(_p.y);
+        _Vertices.push_back(_p.x);
+        _Vertices.push_back(_p.y);
 
         auto Pal = TemperaturePalette_.getColorClip((_s.Temperature)/40000.0);
-        for (auto i=0u; i<3u; ++i) Pos.push_back(Pal[i] * (_s.Temperature/40000.0 + 0.5));
-        Pos.push_back(0.8f);
+        for (auto i=0u; i<3u; ++i) _Vertices.push_back(Pal[i] * (_s.Temperature/40000.0 + 0.5));
+        _Vertices.push_back(0.8f);
     });
-
-    Buffer.setData(Pos, GL::BufferUsage::StaticDraw);
-    MeshGalaxy_.setCount(Pos.size()/6)
-               .setPrimitive(GL::MeshPrimitive::Points)
-               .addVertexBuffer(std::move(Buffer), 0, Shaders::VertexColor2D::Position{}, Shaders::VertexColor2D::Color4{});
-
-    IsGalaxySetup_ = true;
 }
 
 void RenderSystem::cleanupScene()
@@ -304,6 +315,11 @@ void RenderSystem::resetCamera()
     Hook.e = HookDummyObject_;
 }
 
+void RenderSystem::releaseHook(entt::entity _e)
+{
+    if (Reg_.get<HookComponent>(Camera_).e == _e) this->resetCamera();
+}
+
 void RenderSystem::setupCamera()
 {
     Camera_ = Reg_.create();
@@ -40,16 +40,29 @@ class RenderSystem
         entt::entity getCamera() const {return Camera_;}
         int getScale() const {return Scale_;}
         ScaleUnitE getScaleUnit() const {return ScaleUnit_;}
+        int getWindowSizeX() const {return WindowSizeX_;}
+        int getWindowSizeY() const {return WindowSizeY_;}
 
         void buildGalaxyMesh();
+        // Build from vertices (position, color) as given by getGalaxyVertices,
+        // e.g. from the galaxy cache
+        void buildGalaxyMesh(const float* const _Vertices, const std::size_t _Size);
+        void getGalaxyVertices(std::vector<float>& _Vertices);
         void cleanupScene();
+        // Advances smooth zooming, called by renderScene. Camera logic
+        // doesn't need a GL context, e.g. for the headless client
+        void clampZoom();
         void renderScale();
         void renderScene();
         void resetCamera();
+        // Object is about to be destroyed, unhook the camera if attached
+        void releaseHook(entt::entity _e);
         void setRenderResFactor(const double _f) {RenderResFactorTarget_ = _f; this->updateRenderResFactor();}
         void setupCamera();
         void setupGraphics();
         void setWindowSize(const double _x, const double _y);
+        // Tags objects inside the viewport, does not need a GL context
+        void testViewportGalaxy();
 
         DBLK(bool IsGalaxySubLevelsDisplayed{false};)
 
@@ -78,11 +91,9 @@ class RenderSystem
                      int _n, double _f);
         void blurSceneSSAA();
         void checkGalaxyTextureSizes();
-        void clampZoom();
         void createFBOandTex(GL::Framebuffer* const _Fbo, GL::Texture2D* const _Tex, int _SizeX, int _SizeY);
         void renderGalaxy(double _Scale, bool _IsRenderResFactorConsidered = false);
         void subSampleGalaxy();
-        void testViewportGalaxy();
         void updateRenderResFactor();
 
         entt::registry& Reg_;
@@ -0,0 +1,114 @@
+#include "snapshot_system.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "clock_sync.hpp"
+#include "components.hpp"
+#include "ingest_manager.hpp"
+
+void SnapshotSystem::configure(double _Duration, std::size_t _MemoryMax)
+{
+    Duration_ = std::max(_Duration, 0.0);
+
+    const auto Snapshots = static_cast<std::size_t>(std::ceil(Duration_ * RATE_MAX * RATE_TOLERANCE)) + 1;
+    const auto Index = Snapshots * sizeof(SnapshotRing::Snapshot);
+    const auto Records = (_MemoryMax > Index) ? (_MemoryMax - Index) / SnapshotRing::RECORD_SIZE : 0;
+    Ring_.reserve(Snapshots, Records);
+
+    IsPaused_ = false;
+    Selected_ = 0;
+}
+
+void SnapshotSystem::process()
+{
+    Timers_.Snapshot.start();
+
+    if (IsPaused_)
+        this->show();
+    else
+        this->record();
+
+    Timers_.Snapshot.stop();
+    Timers_.SnapshotAvg.addValue(Timers_.Snapshot.elapsed());
+}
+
+void SnapshotSystem::reset()
+{
+    Ring_.clear();
+    IsPaused_ = false;
+    Selected_ = 0;
+}
+
+void SnapshotSystem::setPaused(bool _IsPaused)
+{
+    IsPaused_ = _IsPaused;
+    if (IsPaused_)
+    {
+        Selected_ = Ring_.empty() ? 0 : Ring_.size() - 1;
+        return;
+    }
+    Reg_.view<MotionComponent, PositionComponent>().each(
+        [](const auto& _m, auto& _p)
+        {
+            _p.x = _m.x1;
+            _p.y = _m.y1;
+        });
+}
+
+void SnapshotSystem::select(std::size_t _i)
+{
+    if (Ring_.empty()) return;
+    Selected_ = std::min(_i, Ring_.size() - 1);
+}
+
+double SnapshotSystem::getAge(std::size_t _i) const
+{
+    if (_i >= Ring_.size()) return 0.0;
+    return Ring_[Ring_.size() - 1].ClientTime - Ring_[_i].ClientTime;
+}
+
+void SnapshotSystem::record()
+{
+    const double Now = ClockSync::getClientTime();
+
+    if (SimTime_.getYears() != StampYears_ || SimTime_.getSeconds() != StampSeconds_)
+    {
+        StampYears_ = SimTime_.getYears();
+        StampSeconds_ = SimTime_.getSeconds();
+        StampTime_ = Now;
+    }
+
+    // History is limited by time, too, if updates are slower than RATE_MAX
+    while (!Ring_.empty() && Now - Ring_[0].ClientTime > Duration_) Ring_.dropOldest();
+
+    // One snapshot per server tick, i.e. frame with new positions
+    const auto PositionUpdates = Reg_.ctx<IngestManager>().getPositionUpdates();
+    if (PositionUpdates == PositionUpdates_) return;
+    if (Now - RecordTime_ < 1.0 / (RATE_MAX * RATE_TOLERANCE)) return;
+    PositionUpdates_ = PositionUpdates;
+    RecordTime_ = Now;
+
+    Ring_.begin(StampYears_, StampSeconds_ + (Now - StampTime_) * SimTime_.getAcceleration(), Now);
+    Reg_.view<MotionComponent>().each(
+        [this](auto _e, const auto& _m)
+        {
+            Ring_.add(_e, _m.x1, _m.y1);
+        });
+}
+
+void SnapshotSystem::show()
+{
+    if (Ring_.empty()) return;
+
+    // Live updates are still applied, thus override them every frame
+    Ring_.forEach(Selected_,
+        [this](entt::entity _e, double _x, double _y)
+        {
+            if (!Reg_.valid(_e)) return;
+            auto* p = Reg_.try_get<PositionComponent>(_e);
+            if (p == nullptr) return;
+            p->x = _x;
+            p->y = _y;
+        });
+}
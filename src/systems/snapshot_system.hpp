@@ -0,0 +1,81 @@
+#ifndef SNAPSHOT_SYSTEM_HPP
+#define SNAPSHOT_SYSTEM_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+#include <entt/entity/registry.hpp>
+
+#include "performance_timers.hpp"
+#include "sim_timer.hpp"
+#include "snapshot_ring.hpp"
+
+// Records the positions of dynamic objects as received, once per frame with
+// new positions, into a bounded history (see SnapshotRing). Thus, fast
+// events of the last seconds can be reviewed without the server: while
+// paused, recording stops and the selected snapshot is shown instead of the
+// live state. Snapshots are stamped with the simulation time.
+//
+// Only positions relative to the object's system are recorded. Objects
+// created after the selected snapshot are shown at their live position.
+class SnapshotSystem
+{
+
+    public:
+
+        static constexpr double DURATION_DEFAULT = 30.0;
+        static constexpr double MEMORY_DEFAULT = 64.0; // MiB
+        // Snapshots per second at most, faster updates are thinned out.
+        // Frames at this rate may come a little early, hence the tolerance
+        static constexpr double RATE_MAX = 60.0;
+        static constexpr double RATE_TOLERANCE = 1.1;
+
+        explicit SnapshotSystem(entt::registry& _Reg, PerformanceTimers& _Timers, const SimTimer& _SimTime) :
+            Reg_(_Reg), Timers_(_Timers), SimTime_(_SimTime) {}
+
+        // Keep snapshots of the last _Duration seconds, as far as _MemoryMax
+        // bytes allow. Allocates all memory up front, drops the history
+        void configure(double _Duration, std::size_t _MemoryMax);
+        // Record positions received in this frame or, while paused, show the
+        // selected snapshot. Once per frame after ingesting updates
+        void process();
+        // Scene was cleared, recorded entities are gone
+        void reset();
+        // Pausing selects the newest snapshot, resuming shows the latest
+        // positions received
+        void setPaused(bool _IsPaused);
+        void select(std::size_t _i);
+
+        bool isPaused() const {return IsPaused_;}
+        double getDuration() const {return Duration_;}
+        // Seconds snapshot _i was recorded before the newest one
+        double getAge(std::size_t _i) const;
+        std::size_t getSelected() const {return Selected_;}
+        const SnapshotRing& getRing() const {return Ring_;}
+
+    private:
+
+        void record();
+        void show();
+
+        entt::registry& Reg_;
+        PerformanceTimers& Timers_;
+        const SimTimer& SimTime_;
+
+        SnapshotRing Ring_;
+        double Duration_{0.0};
+
+        bool IsPaused_{false};
+        std::size_t Selected_{0};
+
+        double RecordTime_{0.0};
+        std::uint64_t PositionUpdates_{0};
+
+        // SimTimer is only set by simulation stats, thus it is advanced in
+        // between, starting at the client time it was set
+        std::uint32_t StampYears_{0u};
+        double StampSeconds_{0.0};
+        double StampTime_{0.0};
+};
+
+#endif // SNAPSHOT_SYSTEM_HPP